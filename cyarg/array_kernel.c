@@ -0,0 +1,675 @@
+#include <string.h>
+
+#include "common.h"
+#include "object.h"
+#include "value.h"
+#include "yargtype.h"
+#include "memory.h"
+#include "routine.h"
+#include "array_kernel.h"
+
+// The lane loops below are plain typed C so that host compilers vectorise
+// them (SSE/AVX on x86, NEON on aarch64). The RP2040's M0+ has no SIMD unit,
+// so there narrow adds and subtracts are done a word at a time instead.
+#if defined(CYARG_PICO_SDK_TARGET)
+#define ARRAY_KERNEL_SWAR
+#endif
+
+typedef enum {
+    KERNEL_ADD,
+    KERNEL_SUB,
+    KERNEL_MUL,
+    KERNEL_AND,
+    KERNEL_OR,
+    KERNEL_XOR
+} KernelOp;
+
+typedef struct {
+    uint8_t* bytes;
+    size_t count;
+    size_t width;
+    ObjConcreteYargType* elementType;
+} KernelArray;
+
+static bool isFixedWidthInteger(ObjConcreteYargType* type) {
+    if (type == NULL) {
+        return false;
+    }
+    switch (type->yt) {
+        case TypeInt8:
+        case TypeUint8:
+        case TypeInt16:
+        case TypeUint16:
+        case TypeInt32:
+        case TypeUint32:
+        case TypeInt64:
+        case TypeUint64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool isKernelArray(Value value, KernelArray* array) {
+    if (!IS_UNIFORMARRAY(value)) {
+        return false;
+    }
+    PackedValue store = AS_UNIFORMARRAY(value)->store;
+    ObjConcreteYargTypeArray* type = (ObjConcreteYargTypeArray*) store.storedType;
+    if (!isFixedWidthInteger(type->element_type)
+        || (type->stride != 0 && type->stride != arrayElementSize(type))) {
+        return false;
+    }
+    array->bytes = (uint8_t*) store.storedValue;
+    array->count = type->cardinality;
+    array->width = arrayElementSize(type);
+    array->elementType = type->element_type;
+    return true;
+}
+
+static bool kernelArrayArgument(ObjRoutine* routine, int argCount, int index, KernelArray* array) {
+    if (!isKernelArray(nativeArgument(routine, argCount, index), array)) {
+        runtimeError(routine, "Expected a densely packed array of fixed width integers.");
+        return false;
+    }
+    return true;
+}
+
+static bool sameElements(ObjRoutine* routine, KernelArray const* a, KernelArray const* b) {
+    if (a->elementType->yt != b->elementType->yt) {
+        runtimeError(routine, "Arrays must have the same element type.");
+        return false;
+    }
+    if (a->count != b->count) {
+        runtimeError(routine, "Arrays must have the same length.");
+        return false;
+    }
+    return true;
+}
+
+// The bits of an element of type yt holding value, which is either an int in
+// the range of yt or a value of type yt.
+static bool elementBits(ObjRoutine* routine, ConcreteYargType yt, Value value, uint64_t* bits) {
+    if (IS_INT(value)) {
+        Int const* i = AS_INT(value);
+        int64_t lowest = 0;
+        uint64_t highest = 0;
+        switch (yt) {
+            case TypeInt8: lowest = INT8_MIN; highest = INT8_MAX; break;
+            case TypeUint8: highest = UINT8_MAX; break;
+            case TypeInt16: lowest = INT16_MIN; highest = INT16_MAX; break;
+            case TypeUint16: highest = UINT16_MAX; break;
+            case TypeInt32: lowest = INT32_MIN; highest = INT32_MAX; break;
+            case TypeUint32: highest = UINT32_MAX; break;
+            case TypeInt64: lowest = INT64_MIN; highest = INT64_MAX; break;
+            default: highest = UINT64_MAX; break;
+        }
+        if (int_is_range(i, lowest, highest) != INT_WITHIN) {
+            runtimeError(routine, "Value out of range for the array element type.");
+            return false;
+        }
+        *bits = i->neg_ ? (uint64_t) int_to_i64(i) : int_to_u64(i);
+        return true;
+    }
+
+    bool matches = false;
+    switch (yt) {
+        case TypeInt8: matches = IS_I8(value); *bits = (uint64_t) AS_I8(value); break;
+        case TypeUint8: matches = IS_UI8(value); *bits = AS_UI8(value); break;
+        case TypeInt16: matches = IS_I16(value); *bits = (uint64_t) AS_I16(value); break;
+        case TypeUint16: matches = IS_UI16(value); *bits = AS_UI16(value); break;
+        case TypeInt32: matches = IS_I32(value); *bits = (uint64_t) AS_I32(value); break;
+        case TypeUint32: matches = IS_UI32(value); *bits = AS_UI32(value); break;
+        case TypeInt64: matches = IS_I64(value); *bits = (uint64_t) AS_I64(value); break;
+        default: matches = IS_UI64(value); *bits = AS_UI64(value); break;
+    }
+    if (!matches) {
+        runtimeError(routine, "Expected a value of the array element type.");
+        return false;
+    }
+    return true;
+}
+
+// Eight bytes holding copies of the low width bytes of bits, as they lie in
+// memory. Every lane width divides eight, so the pattern repeats with it.
+static uint64_t broadcastPattern(uint64_t bits, size_t width) {
+    uint8_t lanes[sizeof(uint64_t)];
+    for (size_t offset = 0; offset < sizeof lanes; offset += width) {
+        switch (width) {
+            case 1: { uint8_t v = (uint8_t) bits; memcpy(&lanes[offset], &v, width); break; }
+            case 2: { uint16_t v = (uint16_t) bits; memcpy(&lanes[offset], &v, width); break; }
+            case 4: { uint32_t v = (uint32_t) bits; memcpy(&lanes[offset], &v, width); break; }
+            default: memcpy(&lanes[offset], &bits, width); break;
+        }
+    }
+    uint64_t pattern;
+    memcpy(&pattern, lanes, sizeof pattern);
+    return pattern;
+}
+
+// The first word of a pattern, which is the whole of it for lanes no wider
+// than a word.
+static uintptr_t patternWord(uint64_t pattern) {
+    uintptr_t word;
+    memcpy(&word, &pattern, sizeof word);
+    return word;
+}
+
+static bool wordAligned(void const* p) {
+    return ((uintptr_t) p % sizeof(uintptr_t)) == 0;
+}
+
+#define BYTEWISE(T, OPERATOR) \
+    do { \
+        T* dl = (T*) d; \
+        T const* xl = (T const*) x; \
+        if (y == NULL) { \
+            for (size_t j = 0; j < n; j++) { \
+                dl[j] = xl[j] OPERATOR s; \
+            } \
+        } else { \
+            T const* yl = (T const*) y; \
+            for (size_t j = 0; j < n; j++) { \
+                dl[j] = xl[j] OPERATOR yl[j]; \
+            } \
+        } \
+    } while (false)
+
+#define BITWISE(T) \
+    do { \
+        switch (op) { \
+            case KERNEL_AND: BYTEWISE(T, &); break; \
+            case KERNEL_OR: BYTEWISE(T, |); break; \
+            default: BYTEWISE(T, ^); break; \
+        } \
+    } while (false)
+
+// and, or and xor don't care about lanes so run over whole words of bytes,
+// finishing any odd bytes one at a time. A lane wider than a word, 64 bits
+// on the RP2040, is done a lane at a time instead.
+static void bitwiseKernel(KernelOp op, size_t width, uint8_t* d, uint8_t const* x, uint8_t const* y, uint64_t pattern, size_t bytes) {
+    size_t done = 0;
+    if (width > sizeof(uintptr_t)) {
+        size_t n = bytes / sizeof(uint64_t);
+        uint64_t s = pattern;
+        BITWISE(uint64_t);
+        done = n * sizeof(uint64_t);
+    } else if (wordAligned(d) && wordAligned(x) && (y == NULL || wordAligned(y))) {
+        size_t n = bytes / sizeof(uintptr_t);
+        uintptr_t s = patternWord(pattern);
+        BITWISE(uintptr_t);
+        done = n * sizeof(uintptr_t);
+    }
+    if (done < bytes) {
+        uint8_t const* lanes = (uint8_t const*) &pattern;
+        for (size_t i = done; i < bytes; i++) {
+            uint8_t b = y ? y[i] : lanes[i % sizeof(uint64_t)];
+            switch (op) {
+                case KERNEL_AND: d[i] = x[i] & b; break;
+                case KERNEL_OR: d[i] = x[i] | b; break;
+                default: d[i] = x[i] ^ b; break;
+            }
+        }
+    }
+}
+
+#if defined(ARRAY_KERNEL_SWAR)
+// Adds or subtracts 8 or 16 bit lanes packed in words, keeping carries and
+// borrows inside their lane. Returns the number of bytes done.
+static size_t swarKernel(KernelOp op, size_t width, uint8_t* d, uint8_t const* x, uint8_t const* y, uintptr_t pattern, size_t bytes) {
+    if (!wordAligned(d) || !wordAligned(x) || (y != NULL && !wordAligned(y))) {
+        return 0;
+    }
+    uintptr_t high = width == 1 ? (UINTPTR_MAX / 0xff) * 0x80 : (UINTPTR_MAX / 0xffff) * 0x8000;
+    uintptr_t* dw = (uintptr_t*) d;
+    uintptr_t const* xw = (uintptr_t const*) x;
+    uintptr_t const* yw = (uintptr_t const*) y;
+    size_t words = bytes / sizeof(uintptr_t);
+    for (size_t w = 0; w < words; w++) {
+        uintptr_t a = xw[w];
+        uintptr_t b = yw ? yw[w] : pattern;
+        if (op == KERNEL_ADD) {
+            dw[w] = ((a & ~high) + (b & ~high)) ^ ((a ^ b) & high);
+        } else {
+            dw[w] = ((a | high) - (b & ~high)) ^ ((a ^ ~b) & high);
+        }
+    }
+    return words * sizeof(uintptr_t);
+}
+#endif
+
+// Arithmetic in WIDE, an unsigned type at least as wide as T and int, so
+// that every lane wraps as the interpreter's fixed width operators do.
+#define LANEWISE(T, WIDE, OPERATOR) \
+    do { \
+        T* dl = (T*) d; \
+        T const* xl = (T const*) x; \
+        if (y == NULL) { \
+            WIDE s = (T) scalar; \
+            for (size_t i = 0; i < count; i++) { \
+                dl[i] = (T) ((WIDE) xl[i] OPERATOR s); \
+            } \
+        } else { \
+            T const* yl = (T const*) y; \
+            for (size_t i = 0; i < count; i++) { \
+                dl[i] = (T) ((WIDE) xl[i] OPERATOR (WIDE) yl[i]); \
+            } \
+        } \
+    } while (false)
+
+#define ARITHMETIC(T, WIDE) \
+    do { \
+        switch (op) { \
+            case KERNEL_ADD: LANEWISE(T, WIDE, +); break; \
+            case KERNEL_SUB: LANEWISE(T, WIDE, -); break; \
+            default: LANEWISE(T, WIDE, *); break; \
+        } \
+    } while (false)
+
+static void arithmeticKernel(KernelOp op, size_t width, uint8_t* d, uint8_t const* x, uint8_t const* y, uint64_t scalar, size_t count) {
+#if defined(ARRAY_KERNEL_SWAR)
+    if (width <= 2 && op != KERNEL_MUL) {
+        size_t done = swarKernel(op, width, d, x, y, patternWord(broadcastPattern(scalar, width)), count * width);
+        d += done;
+        x += done;
+        y = y ? y + done : NULL;
+        count -= done / width;
+    }
+#endif
+    switch (width) {
+        case 1: ARITHMETIC(uint8_t, uint32_t); break;
+        case 2: ARITHMETIC(uint16_t, uint32_t); break;
+        case 4: ARITHMETIC(uint32_t, uint32_t); break;
+        default: ARITHMETIC(uint64_t, uint64_t); break;
+    }
+}
+
+static bool elementwiseNative(KernelOp op, ObjRoutine* routine, int argCount) {
+    if (argCount != 3) {
+        runtimeError(routine, "Expected 3 arguments but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray dst, a, b;
+    if (!kernelArrayArgument(routine, argCount, 0, &dst) || !kernelArrayArgument(routine, argCount, 1, &a)) {
+        return false;
+    }
+    if (!sameElements(routine, &dst, &a)) {
+        return false;
+    }
+
+    Value bVal = nativeArgument(routine, argCount, 2);
+    uint8_t const* y = NULL;
+    uint64_t scalar = 0;
+    if (IS_UNIFORMARRAY(bVal)) {
+        if (!kernelArrayArgument(routine, argCount, 2, &b) || !sameElements(routine, &dst, &b)) {
+            return false;
+        }
+        y = b.bytes;
+    } else if (!elementBits(routine, dst.elementType->yt, bVal, &scalar)) {
+        return false;
+    }
+
+    if (op == KERNEL_AND || op == KERNEL_OR || op == KERNEL_XOR) {
+        bitwiseKernel(op, dst.width, dst.bytes, a.bytes, y, broadcastPattern(scalar, dst.width), dst.count * dst.width);
+    } else {
+        arithmeticKernel(op, dst.width, dst.bytes, a.bytes, y, scalar, dst.count);
+    }
+    return true;
+}
+
+bool array_addNative(ObjRoutine* routine, int argCount, Value* result) {
+    return elementwiseNative(KERNEL_ADD, routine, argCount);
+}
+
+bool array_subNative(ObjRoutine* routine, int argCount, Value* result) {
+    return elementwiseNative(KERNEL_SUB, routine, argCount);
+}
+
+bool array_mulNative(ObjRoutine* routine, int argCount, Value* result) {
+    return elementwiseNative(KERNEL_MUL, routine, argCount);
+}
+
+bool array_andNative(ObjRoutine* routine, int argCount, Value* result) {
+    return elementwiseNative(KERNEL_AND, routine, argCount);
+}
+
+bool array_orNative(ObjRoutine* routine, int argCount, Value* result) {
+    return elementwiseNative(KERNEL_OR, routine, argCount);
+}
+
+bool array_xorNative(ObjRoutine* routine, int argCount, Value* result) {
+    return elementwiseNative(KERNEL_XOR, routine, argCount);
+}
+
+bool array_sliceNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 3 && argCount != 4) {
+        runtimeError(routine, "Expected 3 or 4 arguments but got %d.", argCount);
+        return false;
+    }
+
+    Value arrayVal = nativeArgument(routine, argCount, 0);
+    if (!IS_UNIFORMARRAY(arrayVal)) {
+        runtimeError(routine, "Expected an array.");
+        return false;
+    }
+    Value startVal = nativeArgument(routine, argCount, 1);
+    Value lengthVal = nativeArgument(routine, argCount, 2);
+    Value strideVal = argCount == 4 ? nativeArgument(routine, argCount, 3) : NIL_VAL;
+    if (!is_positive_integer32(startVal) || !is_positive_integer32(lengthVal)
+        || (argCount == 4 && (!is_positive_integer32(strideVal) || as_positive_integer32(strideVal) == 0))) {
+        runtimeError(routine, "Expected positive integers for the start, length and stride.");
+        return false;
+    }
+
+    ObjPackedUniformArray* array = AS_UNIFORMARRAY(arrayVal);
+    ObjConcreteYargTypeArray* arrayType = (ObjConcreteYargTypeArray*) array->store.storedType;
+    size_t start = as_positive_integer32(startVal);
+    size_t length = as_positive_integer32(lengthVal);
+    size_t step = argCount == 4 ? as_positive_integer32(strideVal) : 1;
+    if (length == 0 && start <= arrayType->cardinality) {
+        *result = NIL_VAL;
+        return true;
+    }
+    if (start >= arrayType->cardinality || length == 0
+        || (length - 1) > (arrayType->cardinality - 1 - start) / step) {
+        runtimeError(routine, "Slice out of bounds.");
+        return false;
+    }
+
+    ObjConcreteYargTypeArray* viewType = (ObjConcreteYargTypeArray*) newYargArrayTypeFromType(
+        arrayElementType(arrayType), length, arrayElementOffset(arrayType, step));
+    tempRootPush(OBJ_VAL(viewType));
+
+    PackedValue location = arrayElement(array->store, start);
+    location.storedType = (ObjConcreteYargType*) viewType;
+    Obj* owner = array->owner ? array->owner : (Obj*) array;
+    *result = OBJ_VAL(newPackedUniformArrayView(owner, location));
+    tempRootPop();
+    return true;
+}
+
+#define FILL(T) \
+    do { \
+        T* dl = (T*) array.bytes; \
+        T s = (T) bits; \
+        for (size_t i = 0; i < array.count; i++) { \
+            dl[i] = s; \
+        } \
+    } while (false)
+
+bool array_fillNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray array;
+    uint64_t bits;
+    if (!kernelArrayArgument(routine, argCount, 0, &array)
+        || !elementBits(routine, array.elementType->yt, nativeArgument(routine, argCount, 1), &bits)) {
+        return false;
+    }
+
+    uint64_t pattern = broadcastPattern(bits, array.width);
+    if (pattern == 0 || array.width == 1) {
+        memset(array.bytes, (uint8_t) bits, array.count * array.width);
+        return true;
+    }
+    switch (array.width) {
+        case 2: FILL(uint16_t); break;
+        case 4: FILL(uint32_t); break;
+        default: FILL(uint64_t); break;
+    }
+    return true;
+}
+
+bool array_copyNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray dst, src;
+    if (!kernelArrayArgument(routine, argCount, 0, &dst)
+        || !kernelArrayArgument(routine, argCount, 1, &src)
+        || !sameElements(routine, &dst, &src)) {
+        return false;
+    }
+
+    memmove(dst.bytes, src.bytes, dst.count * dst.width);
+    return true;
+}
+
+bool array_copy_rangeNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 5) {
+        runtimeError(routine, "Expected 5 arguments but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray dst, src;
+    if (!kernelArrayArgument(routine, argCount, 0, &dst) || !kernelArrayArgument(routine, argCount, 2, &src)) {
+        return false;
+    }
+    if (dst.elementType->yt != src.elementType->yt) {
+        runtimeError(routine, "Arrays must have the same element type.");
+        return false;
+    }
+
+    Value dstStartVal = nativeArgument(routine, argCount, 1);
+    Value srcStartVal = nativeArgument(routine, argCount, 3);
+    Value countVal = nativeArgument(routine, argCount, 4);
+    if (!is_positive_integer32(dstStartVal) || !is_positive_integer32(srcStartVal) || !is_positive_integer32(countVal)) {
+        runtimeError(routine, "Expected positive integers for the start indexes and count.");
+        return false;
+    }
+
+    size_t dstStart = as_positive_integer32(dstStartVal);
+    size_t srcStart = as_positive_integer32(srcStartVal);
+    size_t count = as_positive_integer32(countVal);
+    if (dstStart > dst.count || count > dst.count - dstStart
+        || srcStart > src.count || count > src.count - srcStart) {
+        runtimeError(routine, "Array range out of bounds.");
+        return false;
+    }
+
+    memmove(dst.bytes + dstStart * dst.width, src.bytes + srcStart * src.width, count * dst.width);
+    return true;
+}
+
+#define SUM(T, ACCUMULATOR) \
+    do { \
+        T const* xl = (T const*) array.bytes; \
+        ACCUMULATOR total = 0; \
+        for (size_t i = 0; i < array.count; i++) { \
+            total += xl[i]; \
+        } \
+        sum = (ACCUMULATOR) total; \
+    } while (false)
+
+// 64 bit lanes are summed into a 128 bit two's complement hi:lo pair.
+#define SUM_WIDE(T, EXTEND) \
+    do { \
+        T const* xl = (T const*) array.bytes; \
+        for (size_t i = 0; i < array.count; i++) { \
+            uint64_t v = (uint64_t) xl[i]; \
+            lo += v; \
+            hi += (lo < v) + EXTEND(xl[i]); \
+        } \
+    } while (false)
+
+#define SIGN_EXTENSION(v) ((v) < 0 ? -1 : 0)
+#define ZERO_EXTENSION(v) 0
+
+bool array_sumNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 1) {
+        runtimeError(routine, "Expected 1 argument but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray array;
+    if (!kernelArrayArgument(routine, argCount, 0, &array)) {
+        return false;
+    }
+
+    switch (array.elementType->yt) {
+        case TypeInt8: case TypeInt16: case TypeInt32: {
+            int64_t sum = 0;
+            switch (array.width) {
+                case 1: SUM(int8_t, int64_t); break;
+                case 2: SUM(int16_t, int64_t); break;
+                default: SUM(int32_t, int64_t); break;
+            }
+            *result = OBJ_VAL(newInt(sum));
+            return true;
+        }
+        case TypeUint8: case TypeUint16: case TypeUint32: {
+            uint64_t sum = 0;
+            switch (array.width) {
+                case 1: SUM(uint8_t, uint64_t); break;
+                case 2: SUM(uint16_t, uint64_t); break;
+                default: SUM(uint32_t, uint64_t); break;
+            }
+            *result = OBJ_VAL(newIntU(sum));
+            return true;
+        }
+        default: {
+            int64_t hi = 0;
+            uint64_t lo = 0;
+            if (array.elementType->yt == TypeInt64) {
+                SUM_WIDE(int64_t, SIGN_EXTENSION);
+            } else {
+                SUM_WIDE(uint64_t, ZERO_EXTENSION);
+            }
+            ObjInt* sum = allocateIntObject(10);
+            int_set_i(hi, &sum->bigInt);
+            int_shift(4, &sum->bigInt);
+            IntConcrete4 low;
+            int_set_u(lo, int_init_concrete4(&low));
+            int_add(&sum->bigInt, (Int const*) &low, &sum->bigInt);
+            *result = OBJ_VAL(sum);
+            return true;
+        }
+    }
+}
+
+#define EXTREME(T, MAKE, BETTER) \
+    do { \
+        T const* xl = (T const*) array.bytes; \
+        T best = xl[0]; \
+        for (size_t i = 1; i < array.count; i++) { \
+            best = xl[i] BETTER best ? xl[i] : best; \
+        } \
+        *result = MAKE(best); \
+    } while (false)
+
+#define EXTREMES(BETTER) \
+    do { \
+        switch (array.elementType->yt) { \
+            case TypeInt8: EXTREME(int8_t, I8_VAL, BETTER); break; \
+            case TypeUint8: EXTREME(uint8_t, UI8_VAL, BETTER); break; \
+            case TypeInt16: EXTREME(int16_t, I16_VAL, BETTER); break; \
+            case TypeUint16: EXTREME(uint16_t, UI16_VAL, BETTER); break; \
+            case TypeInt32: EXTREME(int32_t, I32_VAL, BETTER); break; \
+            case TypeUint32: EXTREME(uint32_t, UI32_VAL, BETTER); break; \
+            case TypeInt64: EXTREME(int64_t, I64_VAL, BETTER); break; \
+            default: EXTREME(uint64_t, UI64_VAL, BETTER); break; \
+        } \
+    } while (false)
+
+bool array_minNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 1) {
+        runtimeError(routine, "Expected 1 argument but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray array;
+    if (!kernelArrayArgument(routine, argCount, 0, &array)) {
+        return false;
+    }
+    if (array.count == 0) {
+        *result = NIL_VAL;
+        return true;
+    }
+
+    EXTREMES(<);
+    return true;
+}
+
+bool array_maxNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 1) {
+        runtimeError(routine, "Expected 1 argument but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray array;
+    if (!kernelArrayArgument(routine, argCount, 0, &array)) {
+        return false;
+    }
+    if (array.count == 0) {
+        *result = NIL_VAL;
+        return true;
+    }
+
+    EXTREMES(>);
+    return true;
+}
+
+bool array_equalNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray a, b;
+    if (!kernelArrayArgument(routine, argCount, 0, &a) || !kernelArrayArgument(routine, argCount, 1, &b)) {
+        return false;
+    }
+
+    *result = BOOL_VAL(a.elementType->yt == b.elementType->yt
+                       && a.count == b.count
+                       && memcmp(a.bytes, b.bytes, a.count * a.width) == 0);
+    return true;
+}
+
+#define FIND(T) \
+    do { \
+        T const* xl = (T const*) array.bytes; \
+        T s = (T) bits; \
+        for (size_t i = 0; i < array.count; i++) { \
+            if (xl[i] == s) { \
+                index = (int64_t) i; \
+                break; \
+            } \
+        } \
+    } while (false)
+
+bool array_findNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+
+    KernelArray array;
+    uint64_t bits;
+    if (!kernelArrayArgument(routine, argCount, 0, &array)
+        || !elementBits(routine, array.elementType->yt, nativeArgument(routine, argCount, 1), &bits)) {
+        return false;
+    }
+
+    int64_t index = -1;
+    switch (array.width) {
+        case 1: {
+            uint8_t const* found = memchr(array.bytes, (uint8_t) bits, array.count);
+            if (found) {
+                index = found - array.bytes;
+            }
+            break;
+        }
+        case 2: FIND(uint16_t); break;
+        case 4: FIND(uint32_t); break;
+        default: FIND(uint64_t); break;
+    }
+    *result = OBJ_VAL(newInt(index));
+    return true;
+}
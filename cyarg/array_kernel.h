@@ -0,0 +1,29 @@
+#ifndef cyarg_array_kernel_h
+#define cyarg_array_kernel_h
+
+#include "value.h"
+
+// A view of part of an array, sharing its storage rather than copying it.
+bool array_sliceNative(ObjRoutine* routine, int argCount, Value* result);
+
+// Bulk operations over packed arrays of fixed width integers, run as single
+// native loops rather than one OP_ELEMENT dispatch per element.
+
+bool array_fillNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_copyNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_copy_rangeNative(ObjRoutine* routine, int argCount, Value* result);
+
+bool array_addNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_subNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_mulNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_andNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_orNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_xorNative(ObjRoutine* routine, int argCount, Value* result);
+
+bool array_sumNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_minNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_maxNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_equalNative(ObjRoutine* routine, int argCount, Value* result);
+bool array_findNative(ObjRoutine* routine, int argCount, Value* result);
+
+#endif
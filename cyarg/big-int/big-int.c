@@ -148,15 +148,11 @@ void int_set_u(uint64_t to, Int *i)
     }
 }
 
-static IntConcrete2 const ten = {.m_ = 2, .d_ = 1, .w_[0] = 10};
-
+// Nine decimal digits at a time, each step a single word multiply-accumulate of the
+// digits so far by 10^9.
 void int_set_s(char const *s, Int *i)
 {
     int_init(i);
-    IntConcrete2 digit;
-    int_init_concrete2(&digit);
-    IntConcrete254 acc;
-    int_init_concrete254(&acc);
 
     bool neg;
     if (*s == '-')
@@ -168,13 +164,45 @@ void int_set_s(char const *s, Int *i)
     {
         neg = false;
     }
+
+    uint32_t *const w = i->w_;
+    int const capacity = i->m_ / 2;
+    int nw = 1;
     while (*s != 0)
     {
-        int_mul((Int *) &ten, i, (Int *) &acc); // todo mul by uint16 optimisation
-        int d = *s++ - '0';
-        int_set_i(d, (Int *) &digit); // todo add to uint16 optimisation
-        int_add((Int *) &acc, (Int *) &digit, i);
+        uint32_t chunk = 0;
+        uint32_t scale = 1;
+        for (int c = 0; c < 9 && *s != 0; c++)
+        {
+            chunk = chunk * 10u + (uint32_t) (*s++ - '0');
+            scale *= 10u;
+        }
+
+        uint64_t carry = chunk;
+        for (int k = 0; k < nw; k++)
+        {
+            carry += (uint64_t) w[k] * scale;
+            w[k] = (uint32_t) carry;
+            carry >>= 32;
+        }
+        if (carry != 0)
+        {
+            if (nw == capacity)
+            {
+                i->overflow_ = true;
+                break;
+            }
+            w[nw++] = (uint32_t) carry;
+        }
+    }
+
+    uint16_t const *const h = (uint16_t const *) w;
+    int d = 2 * nw;
+    while (d > 1 && h[d - 1] == 0u)
+    {
+        d--;
     }
+    i->d_ = (uint8_t) d;
     i->neg_ = neg;
 }
 
@@ -415,41 +443,311 @@ static void subAGtB(Int const *a, Int const *b, Int *r)
     }
 }
 
-void int_mul(Int const *a, Int const *b, Int *r)
+// Multiplication works on the 32-bit words of the digits (two 16-bit digits a word,
+// the unused high digit of an odd length Int always zero) with a multiply-accumulate
+// inner loop. Operands of INT_KARATSUBA_WORDS words or more are split Karatsuba style,
+// three half size products in place of four, and a square only computes each cross
+// product once.
+#define INT_WORDS_FOR_INT254 127
+#define INT_KARATSUBA_WORDS 24
+#define INT_MUL_SCRATCH_WORDS 264 // enough for a 128 word product split down to INT_KARATSUBA_WORDS
+
+// Word temporaries come from a scratch arena, one a core (a thread when hosted), rather
+// than the C stack, and are sized to the operands rather than to INT_WORDS_FOR_INT254.
+// Taking words bumps the arena's top and giving them back restores it, so use is strictly
+// LIFO. An interrupt handler doing int arithmetic gives back everything it took before the
+// code it interrupted resumes, leaving top as it found it.
+#define INT_SCRATCH_WORDS (2 * (INT_WORDS_FOR_INT254 + 1 + INT_MUL_SCRATCH_WORDS)) // a full size product, and another interrupting it
+
+typedef struct
 {
-    IntConcrete254 pp;
-    int_init_concrete254(&pp);
+    int volatile top_;
+    uint32_t w_[INT_SCRATCH_WORDS];
+} IntScratch;
+
+#if defined(CYARG_PICO_SDK_TARGET)
+#include <pico/platform.h>
+static IntScratch intScratch[NUM_CORES];
+#define INT_SCRATCH (&intScratch[get_core_num()])
+#else
+static _Thread_local IntScratch intScratch;
+#define INT_SCRATCH (&intScratch)
+#endif
 
-    int_set_i(0, r);
-    uint16_t *const rh = (uint16_t *) r->w_;
-    uint16_t const *const ah = (uint16_t const *) a->w_;
-    uint16_t const *const bh = (uint16_t const *) b->w_;
+static uint32_t *scratchTake(int words)
+{
+    IntScratch *const s = INT_SCRATCH;
+    int const top = s->top_;
+    assert(top + words <= INT_SCRATCH_WORDS);
+    s->top_ = top + words;
+    return &s->w_[top];
+}
+
+static void scratchGiveBack(uint32_t *from) // from, and everything taken after it
+{
+    IntScratch *const s = INT_SCRATCH;
+    assert(from >= s->w_ && from <= &s->w_[s->top_]);
+    s->top_ = (int) (from - s->w_);
+}
 
-    uint16_t *rpn = rh;
-    for (uint16_t const *ap = ah; ap < &ah[a->d_]; ap++)
+static uint32_t addWords(uint32_t *r, int nr, uint32_t const *a, int na) // r += a, returns the carry out
+{
+    uint64_t carry = 0;
+    int i = 0;
+    for (; i < na; i++)
+    {
+        carry += (uint64_t) r[i] + a[i];
+        r[i] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    for (; carry != 0 && i < nr; i++)
+    {
+        carry += r[i];
+        r[i] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    return (uint32_t) carry;
+}
+
+static void subWords(uint32_t *r, int nr, uint32_t const *a, int na) // r -= a, r >= a
+{
+    uint32_t borrow = 0;
+    int i = 0;
+    for (; i < na; i++)
+    {
+        uint64_t d = (uint64_t) r[i] - a[i] - borrow;
+        r[i] = (uint32_t) d;
+        borrow = (uint32_t) (d >> 63);
+    }
+    for (; borrow != 0 && i < nr; i++)
+    {
+        borrow = r[i] == 0u;
+        r[i]--;
+    }
+}
+
+static void mulBasecase(uint32_t const *a, int na, uint32_t const *b, int nb, uint32_t *r) // r[na + nb] = a * b
+{
+    memset(r, 0, nb * sizeof r[0]);
+    for (int i = 0; i < na; i++)
     {
-        uint16_t *rp = rpn;
-        rpn = rp + 1;
-//        printf("%ld->%ld", ap - a->h_, rp - r->h_);
-        for (uint16_t const *bp = bh; bp < &bh[b->d_]; bp++, rp++)
+        uint64_t carry = 0;
+        uint64_t const ai = a[i];
+        for (int j = 0; j < nb; j++)
         {
-//            printf(".%ld/%ld", ap - a->h_, bp - b->h_);
-            int_set_i((uint32_t) *ap * (uint32_t) *bp, (Int *) &pp); // todo cast to int32 to use M0 single instruction mul
-            if (rp - rh + pp.d_ > r->m_)
-            {
-                r->overflow_ = true;
-                break;
-            }
-            int_shift((int)(rp - rh), (Int *) &pp);
-//            printf("%d:%d := %d %d\n", (int)pp.h16_, (int)pp.l16_, (int)*ap, (int)*bp);
-            int_add(r, (Int *) &pp, r); // todo add shifted uint32 optimisation
-            if (r->overflow_)
-            {
-                break;
-            }
+            carry += ai * b[j] + r[i + j];
+            r[i + j] = (uint32_t) carry;
+            carry >>= 32;
+        }
+        r[i + nb] = (uint32_t) carry;
+    }
+}
+
+static void sqrBasecase(uint32_t const *a, int n, uint32_t *r) // r[2n] = a * a
+{
+    memset(r, 0, 2 * n * sizeof r[0]);
+    for (int i = 0; i < n - 1; i++)
+    {
+        uint64_t carry = 0;
+        uint64_t const ai = a[i];
+        for (int j = i + 1; j < n; j++)
+        {
+            carry += ai * a[j] + r[i + j];
+            r[i + j] = (uint32_t) carry;
+            carry >>= 32;
         }
+        r[i + n] = (uint32_t) carry;
+    }
+
+    uint32_t top = 0;
+    for (int k = 0; k < 2 * n; k++)
+    {
+        uint32_t const w = r[k];
+        r[k] = (w << 1) | top;
+        top = w >> 31;
+    }
+
+    uint64_t carry = 0;
+    for (int i = 0; i < n; i++)
+    {
+        carry += (uint64_t) a[i] * a[i] + r[2 * i];
+        r[2 * i] = (uint32_t) carry;
+        carry >>= 32;
+        carry += r[2 * i + 1];
+        r[2 * i + 1] = (uint32_t) carry;
+        carry >>= 32;
+    }
+}
+
+// a = a1.B^m + a0, b = b1.B^m + b0
+// a.b = z2.B^2m + (z1 - z2 - z0).B^m + z0 with z2 = a1.b1, z0 = a0.b0, z1 = (a1 + a0).(b1 + b0)
+static void mulWords(uint32_t const *a, int na, uint32_t const *b, int nb, uint32_t *r, uint32_t *scratch) // r[na + nb] = a * b
+{
+    if (na < nb)
+    {
+        uint32_t const *t = a; a = b; b = t;
+        int nt = na; na = nb; nb = nt;
+    }
+    int const m = (na + 1) / 2;
+    if (nb < INT_KARATSUBA_WORDS || nb <= m)
+    {
+        mulBasecase(a, na, b, nb, r);
+        return;
+    }
+
+    uint32_t *const sa = scratch;
+    uint32_t *const sb = &sa[m + 1];
+    uint32_t *const z1 = &sb[m + 1];
+    uint32_t *const next = &z1[2 * m + 2];
+    assert(next - scratch <= INT_MUL_SCRATCH_WORDS);
+
+    memcpy(sa, a, m * sizeof a[0]);
+    sa[m] = addWords(sa, m, &a[m], na - m);
+    memcpy(sb, b, m * sizeof b[0]);
+    sb[m] = addWords(sb, m, &b[m], nb - m);
+
+    mulWords(a, m, b, m, r, next);
+    mulWords(&a[m], na - m, &b[m], nb - m, &r[2 * m], next);
+    mulWords(sa, m + 1, sb, m + 1, z1, next);
+
+    subWords(z1, 2 * m + 2, r, 2 * m);
+    subWords(z1, 2 * m + 2, &r[2 * m], na + nb - 2 * m);
+    int const nz1 = na + nb - m < 2 * m + 2 ? na + nb - m : 2 * m + 2; // z1 - z2 - z0 = a1.b0 + a0.b1 < B^(na + nb - m)
+    addWords(&r[m], na + nb - m, z1, nz1);
+}
+
+static void sqrWords(uint32_t const *a, int n, uint32_t *r, uint32_t *scratch) // r[2n] = a * a
+{
+    if (n < INT_KARATSUBA_WORDS)
+    {
+        sqrBasecase(a, n, r);
+        return;
+    }
+
+    int const m = (n + 1) / 2;
+    uint32_t *const sa = scratch;
+    uint32_t *const z1 = &sa[m + 1];
+    uint32_t *const next = &z1[2 * m + 2];
+    assert(next - scratch <= INT_MUL_SCRATCH_WORDS);
+
+    memcpy(sa, a, m * sizeof a[0]);
+    sa[m] = addWords(sa, m, &a[m], n - m);
+
+    sqrWords(a, m, r, next);
+    sqrWords(&a[m], n - m, &r[2 * m], next);
+    sqrWords(sa, m + 1, z1, next);
+
+    subWords(z1, 2 * m + 2, r, 2 * m);
+    subWords(z1, 2 * m + 2, &r[2 * m], 2 * n - 2 * m);
+    int const nz1 = 2 * n - m < 2 * m + 2 ? 2 * n - m : 2 * m + 2;
+    addWords(&r[m], 2 * n - m, z1, nz1);
+}
+
+static int mulScratchWords(int na, int nb) // the scratch mulWords (or sqrWords, with nb == na) uses
+{
+    if (na < nb)
+    {
+        int nt = na; na = nb; nb = nt;
+    }
+    int const m = (na + 1) / 2;
+    if (nb < INT_KARATSUBA_WORDS || nb <= m)
+    {
+        return 0;
+    }
+    int next = mulScratchWords(m + 1, m + 1);
+    int const high = mulScratchWords(na - m, nb - m);
+    if (high > next)
+    {
+        next = high;
+    }
+    return 4 * m + 4 + next;
+}
+
+static void mulLarge(uint32_t const *a, int na, uint32_t const *b, int nb, uint32_t *p)
+{
+    uint32_t *const scratch = scratchTake(mulScratchWords(na, nb));
+    if (a == b)
+    {
+        sqrWords(a, na, p, scratch);
+    }
+    else
+    {
+        mulWords(a, na, b, nb, p, scratch);
+    }
+    scratchGiveBack(scratch);
+}
+
+static void mulInto(uint32_t const *a, int na, uint32_t const *b, int nb, uint32_t *p)
+{
+    if (na >= INT_KARATSUBA_WORDS && nb >= INT_KARATSUBA_WORDS)
+    {
+        mulLarge(a, na, b, nb, p);
+    }
+    else if (a == b)
+    {
+        sqrBasecase(a, na, p);
+    }
+    else if (na >= nb)
+    {
+        mulBasecase(a, na, b, nb, p);
+    }
+    else
+    {
+        mulBasecase(b, nb, a, na, p);
+    }
+}
+
+static void setWords(uint32_t const *p, int np, bool neg, Int *r)
+{
+    uint16_t const *const ph = (uint16_t const *) p;
+    int d = 2 * np;
+    while (d > 1 && ph[d - 1] == 0u)
+    {
+        d--;
+    }
+    if (d > r->m_)
+    {
+        int_set_i(0, r);
+        r->overflow_ = true;
+        return;
+    }
+    if (p != r->w_)
+    {
+        memcpy(r->w_, p, (d + 1) / 2 * sizeof p[0]);
+    }
+    r->d_ = (uint8_t) d;
+    r->overflow_ = false;
+    r->neg_ = neg;
+}
+
+static void mulThroughTemporary(Int const *a, int na, Int const *b, int nb, Int *r)
+{
+    uint32_t *const p = scratchTake(na + nb);
+    mulInto(a->w_, na, b->w_, nb, p);
+    setWords(p, na + nb, a->neg_ ^ b->neg_, r);
+    scratchGiveBack(p);
+}
+
+void int_mul(Int const *a, Int const *b, Int *r)
+{
+    if (a->d_ + b->d_ - 1 > r->m_) // the product has at least a->d_ + b->d_ - 1 digits
+    {
+        int_set_i(0, r);
+        r->overflow_ = true;
+        return;
+    }
+
+    int const na = (a->d_ + 1) / 2;
+    int const nb = (b->d_ + 1) / 2;
+    if (na + nb <= r->m_ / 2 && r != a && r != b)
+    {
+        mulInto(a->w_, na, b->w_, nb, r->w_);
+        setWords(r->w_, na + nb, a->neg_ ^ b->neg_, r);
+    }
+    else
+    {
+        mulThroughTemporary(a, na, b, nb, r);
     }
-    r->neg_ = a->neg_ ^ b->neg_;
 }
 
 /*
@@ -475,14 +773,87 @@ void int_mul(Int const *a, Int const *b, Int *r)
           =======
             81255 RN<SD && D==SD Terminate
  */
+static uint32_t divWordsByWord(uint32_t *w, int nw, uint32_t divisor) // w /= divisor in place, returns the remainder
+{
+    uint64_t rem = 0;
+    for (int k = nw - 1; k >= 0; k--)
+    {
+        uint64_t const t = (rem << 32) | w[k];
+        w[k] = (uint32_t) (t / divisor);
+        rem = t % divisor;
+    }
+    return (uint32_t) rem;
+}
+
+static int leadingZeros(uint32_t x)
+{
+    int z = 0;
+    while ((x & 0x80000000u) == 0u)
+    {
+        x <<= 1;
+        z++;
+    }
+    return z;
+}
+
+// Knuth, TAOCP vol 2, 4.3.1 Algorithm D on 32-bit words, after Hacker's Delight divmnu.
+// un[m + 1] holds the normalised dividend, and on return the remainder in un[0..n) and
+// the quotient in un[n..m], each quotient word replacing the dividend word it clears.
+static void divKnuth(uint32_t *un, int m, uint32_t const *vn, int n)
+{
+    for (int j = m - n; j >= 0; j--)
+    {
+        uint64_t const num = ((uint64_t) un[j + n] << 32) | un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1];
+        uint64_t rhat = num - qhat * vn[n - 1];
+        while (qhat > 0xffffffffu || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2]))
+        {
+            qhat--;
+            rhat += vn[n - 1];
+            if (rhat > 0xffffffffu)
+            {
+                break;
+            }
+        }
+
+        int64_t borrow = 0;
+        int64_t t;
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t const p = qhat * vn[i];
+            t = (int64_t) un[i + j] - borrow - (int64_t) (p & 0xffffffffu);
+            un[i + j] = (uint32_t) t;
+            borrow = (int64_t) (p >> 32) - (t >> 32);
+        }
+        t = (int64_t) un[j + n] - borrow;
+        un[j + n] = (uint32_t) t;
+
+        if (t < 0) // qhat was one too large, add back
+        {
+            qhat--;
+            uint64_t carry = 0;
+            for (int i = 0; i < n; i++)
+            {
+                carry += (uint64_t) un[i + j] + vn[i];
+                un[i + j] = (uint32_t) carry;
+                carry >>= 32;
+            }
+        }
+        un[j + n] = (uint32_t) qhat;
+    }
+}
+
 void int_div(Int const *n, Int const *d, Int *q, Int *r)
 {
     if (int_is_abs(n, d) == INT_LT)
     {
+        if (q != 0)
+        {
+            int_init(q);
+        }
         if (r != 0)
         {
             int_set_t(n, r);
-            int_init(q);
             // adjust for yarg’s weird %
             if (n->neg_)
             {
@@ -498,116 +869,65 @@ void int_div(Int const *n, Int const *d, Int *q, Int *r)
         return;
     }
 
-    bool nSign = n->neg_;
-    bool dSign = d->neg_;
-
-    IntConcrete254 qDigit;
-    int_init_concrete254(&qDigit);
-    IntConcrete254 reduceBy;
-    int_init_concrete254(&reduceBy);
-    IntConcrete254 reducingNumerator;
-    int_init_concrete254(&reducingNumerator);
-    IntConcrete254 shiftingDenominator;
-    int_init_concrete254(&shiftingDenominator);
-
-    uint16_t const *const dh = (uint16_t const *) d->w_;
-    uint32_t testDenominator = dh[d->d_ - 1];
-    assert(testDenominator != 0);
-    testDenominator++;
+    bool const nSign = n->neg_;
+    bool const dSign = d->neg_;
+    int const nw = (n->d_ + 1) / 2;
+    int const dw = (d->d_ + 1) / 2;
+    assert(d->w_[dw - 1] != 0u);
 
-    // Shift denominator to be one digit to the right of the numerator
-    // if n and d are the same length, assume numerator is one longer. Increase wirh a leading zero.
-    int_set_t(n, (Int *) &reducingNumerator);
-    reducingNumerator.neg_ = false;
-    int nDigit = reducingNumerator.d_ - 1;
+    // the quotient and remainder come out of the one pass, either may be dropped
+    uint32_t *const un = scratchTake(nw + 1 + dw);
+    uint32_t *const rem = &un[nw + 1];
 
-    int_set_t(d, (Int *) &shiftingDenominator);
-    shiftingDenominator.neg_ = false;
-    int shift = reducingNumerator.d_ - shiftingDenominator.d_ - 1;
-    if (shift == -1)
+    if (dw == 1)
     {
-        shift = 0;
-        nDigit++;
-    }
-    else if (shift >= 1)
-    {
-        int_shift(shift, (Int *) &shiftingDenominator);
+        memcpy(un, n->w_, nw * sizeof un[0]);
+        rem[0] = divWordsByWord(un, nw, d->w_[0]);
+        if (q != 0)
+        {
+            setWords(un, nw, nSign ^ dSign, q);
+        }
     }
     else
     {
-        assert(shift == 0);
-    }
-    int_init(q);
-
-    while (1)
-    {
-        if (int_is_abs((Int *) &reducingNumerator, (Int *) &shiftingDenominator) == INT_LT) // should never be true on first iteration
+        // normalise so the divisor's top word has its top bit set
+        int const shift = leadingZeros(d->w_[dw - 1]);
+        uint32_t *const vn = rem;
+        for (int i = dw - 1; i > 0; i--)
         {
-            if (shift == 0)
-            {
-                break;
-            }
-            else
-            {
-                shift--;
-                nDigit--;
-                //shifts++;
-                int_shift(-1, (Int *) &shiftingDenominator);
-                int_shift(1, q);
-                if (q->overflow_)
-                {
-                    return;
-                }
-            }
+            vn[i] = (uint32_t) (((uint64_t) d->w_[i] << shift) | ((uint64_t) d->w_[i - 1] >> (32 - shift)));
         }
-
-        uint16_t const *const rnh = (uint16_t const *) reducingNumerator.w_;
-        TwoDigits guessNumerator;
-        if (nDigit < 1)
+        vn[0] = d->w_[0] << shift;
+        un[nw] = (uint32_t) ((uint64_t) n->w_[nw - 1] >> (32 - shift));
+        for (int i = nw - 1; i > 0; i--)
         {
-            assert(nDigit == 0);
-            guessNumerator.u32_ = rnh[0];
-        }
-        else
-        {
-            if (nDigit >= reducingNumerator.d_) // todo - combine with the preceding test
-            {
-                guessNumerator.h16_ = 0u;
-            }
-            else
-            {
-                guessNumerator.h16_ = rnh[nDigit];
-            }
-            guessNumerator.l16_ = rnh[nDigit - 1];
-        }
-        uint32_t guessMultiplier = guessNumerator.u32_ / testDenominator; // todo compare div_u32u32();
-        if (guessMultiplier == 0u)
-        {
-            guessMultiplier = 1u;
+            un[i] = (uint32_t) (((uint64_t) n->w_[i] << shift) | ((uint64_t) n->w_[i - 1] >> (32 - shift)));
         }
+        un[0] = n->w_[0] << shift;
 
-        int_set_i(guessMultiplier, (Int *) &qDigit);
-        int_mul((Int *) &shiftingDenominator, (Int *) &qDigit, (Int *) &reduceBy);
+        divKnuth(un, nw, vn, dw);
 
-        if (int_is_abs((Int *) &reducingNumerator, (Int *) &reduceBy) != INT_LT)
+        for (int i = 0; i < dw - 1; i++)
         {
-            subAGtB((Int *) &reducingNumerator, (Int *) &reduceBy, (Int *) &reducingNumerator);
-            addPos((Int *) &qDigit, q, q);
+            rem[i] = (uint32_t) (((uint64_t) un[i] >> shift) | ((uint64_t) un[i + 1] << (32 - shift)));
+        }
+        rem[dw - 1] = un[dw - 1] >> shift;
+        if (q != 0)
+        {
+            setWords(&un[dw], nw - dw + 1, nSign ^ dSign, q);
         }
-        else // Guessed too high
-            ;
     }
-    q->neg_ = nSign ^ dSign;
+
     if (r != 0)
     {
-        int_set_t((Int *) &reducingNumerator, r);
-        r->neg_ = nSign;
+        setWords(rem, dw, nSign, r);
         // adjust for yarg’s weird %
         if (nSign)
         {
             int_add(r, d, r);
         }
     }
+    scratchGiveBack(un);
 }
 
 void int_neg(Int *i)
@@ -688,9 +1008,9 @@ IntComp int_is_abs(Int const *a, Int const *b)
 IntRange int_is_range(Int const *i, int64_t l, uint64_t u)
 {
     IntRange r;
-    IntConcrete254 t;
+    IntConcrete4 t;
 
-    int_init_concrete254(&t);
+    int_init_concrete4(&t);
 
     int_set_u(u, (Int *) &t);
     if (int_is(i, (Int *) &t) == INT_GT)
@@ -714,39 +1034,36 @@ IntRange int_is_range(Int const *i, int64_t l, uint64_t u)
 }
 
 static const IntConcrete2 tenToTheFour = {.m_ = 2, .d_ = 1, .w_[0] = 10000u};
-static const IntConcrete4 tenToTheNineteen = {.m_ = 4, .d_ = 4, .w_ = {2313682944u, 2328306436u}}; // 10000000000000000000
-
+// Nine decimal digits at a time, each step a single word division by 10^9.
 char const *int_to_s(Int const *i, char *s, int n)
 {
     char *out = &s[n - 1];
     *out = '\0';
 
-    IntConcrete254 v;
-    int_init_concrete254(&v);
-
-    int_set_t(i, (Int *) &v);
-    v.neg_ = false;
-
-    static IntConcrete4 r;
-    int_init_concrete4(&r);
+    int nw = (i->d_ + 1) / 2;
+    uint32_t *const w = scratchTake(nw);
+    memcpy(w, i->w_, nw * sizeof w[0]);
 
-    while (!int_is_zero((Int *) &v))
+    while (nw > 1 || w[0] != 0u)
     {
-        int_div((Int *) &v, (Int *) &tenToTheNineteen, (Int *) &v, (Int *) &r);
-
-        FourDigits rem = {.l32_ = r.w_[0], .h32_ = r.d_ > 2 ? r.w_[1] : 0u};
-        bool leading = int_is_zero((Int *) &v);
-        for (int c = 0; c < 19 && out > s; c++)
+        uint32_t rem = divWordsByWord(w, nw, 1000000000u);
+        while (nw > 1 && w[nw - 1] == 0u)
+        {
+            nw--;
+        }
+        bool const leading = nw == 1 && w[0] == 0u;
+        for (int c = 0; c < 9 && out > s; c++)
         {
-            char ch = (char) (rem.ull64_ % 10u + '0');
-            if (!leading || rem.ull64_ != 0)
+            char ch = (char) (rem % 10u + '0');
+            if (!leading || rem != 0)
             {
                 *--out = ch;
             }
-            rem.ull64_ /= 10u;
+            rem /= 10u;
         }
     }
-    if (out == &s[n - 1]) // todo optimise - break to for loop above if rem and v are zero
+    scratchGiveBack(w);
+    if (out == &s[n - 1])
     {
         *--out = '0';
     }
@@ -15,7 +15,11 @@
 #include "channel.h"
 #include "yargtype.h"
 #include "sync_group.h"
+#include "map.h"
 #include "pack.h"
+#if defined(CYARG_FEATURE_HOSTED_REPL)
+#include "hosted.h"
+#endif
 
 #ifdef CYARG_FEATURE_TEST_SYSTEM
 #include "test-system/testSystem.h"
@@ -59,29 +63,44 @@ bool readBinaryBuiltin(ObjRoutine* routineContext, int argCount, Value* result)
     Value pathVal = nativeArgument(routineContext, argCount, 0);
     const char* c_pathString = AS_CSTRING(pathVal);
 
-    size_t file_size = fileSize(c_pathString);
+    // A mapped file is paged in as it is read and never counts towards the heap.
+    size_t file_size = 0;
+    uint8_t* mapped = mapFile(c_pathString, &file_size);
+    if (mapped == NULL) {
+        file_size = fileSize(c_pathString);
+    }
 
-    ObjConcreteYargType* byteType = newYargTypeFromType(TypeUint8);
-    tempRootPush(OBJ_VAL(byteType));
+    // The array owns the mapping, and a package loaded from it keeps the array.
+    if (mapped != NULL) {
+        *result = OBJ_VAL(newMappedByteArray(mapped, file_size));
+        return true;
+    }
 
-    ObjConcreteYargTypeArray* arrayType = (ObjConcreteYargTypeArray*)newYargArrayTypeFromType(OBJ_VAL(byteType));
+    ObjConcreteYargType* byteType = newYargTypeFromType(TypeUint8);
+    ObjConcreteYargTypeArray* arrayType = (ObjConcreteYargTypeArray*)newYargArrayTypeFromType(OBJ_VAL(byteType), file_size, 0);
     tempRootPush(OBJ_VAL(arrayType));
 
-    arrayType->cardinality = file_size;
     ObjPackedUniformArray* array = newPackedUniformArray(arrayType);
     tempRootPush(OBJ_VAL(array));
-
     readFileIntoBuffer(c_pathString, (uint8_t*)array->store.storedValue, file_size);
 
     *result = OBJ_VAL(array);
 
-    tempRootPop();
     tempRootPop();
     tempRootPop();
 
     return true;
 }
 
+static ObjFunction* compileSource(const char* source) {
+#if defined(CYARG_FEATURE_HOSTED_REPL)
+    if (vmHost.cachePath != NULL) {
+        return compileCached(source, vmHost.cachePath);
+    }
+#endif
+    return compile(source);
+}
+
 bool compileBuiltin(ObjRoutine* routineContext, int argCount, Value* result) {
     if (argCount != 1) {
         runtimeError(routineContext, "Expected 1 argument but got %d.", argCount);
@@ -93,7 +112,7 @@ bool compileBuiltin(ObjRoutine* routineContext, int argCount, Value* result) {
     }
 
     const char* source = AS_CSTRING(nativeArgument(routineContext, argCount, 0));
-    ObjFunction* function = compile(source);
+    ObjFunction* function = compileSource(source);
     if (function == NULL) {
         *result = NIL_VAL;
     } else {
@@ -105,6 +124,15 @@ bool compileBuiltin(ObjRoutine* routineContext, int argCount, Value* result) {
     return true;
 }
 
+static bool isPlacedByteArray(ObjPackedPointer* pointer) {
+    ObjConcreteYargType* target = pointer->type->target_type;
+    if (target == NULL || target->yt != TypeArray) {
+        return false;
+    }
+    ObjConcreteYargType* element = ((ObjConcreteYargTypeArray*)target)->element_type;
+    return element != NULL && (element->yt == TypeUint8 || element->yt == TypeInt8);
+}
+
 bool loadBuiltin(ObjRoutine* routineContext, int argCount, Value* result) {
     if (argCount != 1) {
         runtimeError(routineContext, "Expected 1 arguments but got %d.", argCount);
@@ -114,12 +142,17 @@ bool loadBuiltin(ObjRoutine* routineContext, int argCount, Value* result) {
     ObjFunction* function = NULL;
     
     if (IS_UNIFORMARRAY(arg)) {
+        // the functions loaded keep the array, which their code runs from, alive
         ObjPackedUniformArray* array = AS_UNIFORMARRAY(arg);
-        uintptr_t addr = pinUniformArray(array);
-        function = loadPackageFromBuffer((uint8_t*)addr, arrayCardinality(array->store));
+        function = loadPackageFromBuffer((uint8_t*)array->store.storedValue, arrayCardinality(array->store), (Obj*)array);
+    } else if (IS_POINTER(arg) && isPlacedByteArray(AS_POINTER(arg))) {
+        // An image placed in memory mapped flash is loaded where it is; its code
+        // and strings are executed and referenced in place, never copied to RAM.
+        PackedValue image = pointerTargetStore(arg);
+        function = loadPackageFromBuffer((uint8_t*)image.storedValue, arrayCardinality(image), NULL);
     } else if (IS_STRING(arg)) {
         const char* source = AS_CSTRING(arg);
-        function = compile(source);
+        function = compileSource(source);
     } else {
         runtimeError(routineContext, "Argument to load must be a byte array or a string.");
         return false;
@@ -401,7 +434,7 @@ bool lenBuiltin(ObjRoutine* routineContext, int argCount, Value* result) {
         return true;
     } else if (IS_MAP(arg)) {
         ObjMap* map = AS_MAP(arg);
-        size_t count = map->entries.count;
+        size_t count = mapCount(map);
         *result = OBJ_VAL(newIntU(count));
         return true;
     } else {
@@ -66,7 +66,17 @@ typedef enum {
     OP_SET_CELL_TYPE,
     OP_DEREF_PTR,
     OP_SET_PTR_TARGET,
-    OP_PLACE
+    OP_PLACE,
+    OP_SET_LOCAL_FIXED,
+    OP_TAIL_CALL,
+    OP_INT_TEMPORARY,
+    OP_GET_LOCAL_INT,
+    OP_UPDATE_LOCAL_INT,
+    OP_DEREF_PTR_ELEMENT,
+    OP_SET_PTR_ELEMENT,
+    OP_DEREF_PTR_PROPERTY,
+    OP_SET_PTR_PROPERTY,
+    OP_WIDE             // high byte of the following instruction's constant index
 } OpCode;
 
 typedef struct {
@@ -23,6 +23,8 @@ typedef struct {
     ObjString* name;
     int depth;
     bool isCaptured;
+    ValueType fixedType; // VAL_NIL unless declared with a fixed width type; its stores are OP_SET_LOCAL_FIXED.
+    bool isInt; // declared int, so the local may own its ObjInt, see OP_UPDATE_LOCAL_INT.
 } Local;
 
 typedef struct {
@@ -80,6 +82,8 @@ static void initCompiler(Compiler* compiler, FunctionType type, ObjString* name)
     local->name = NULL;
     local->depth = 0;
     local->isCaptured = false;
+    local->fixedType = VAL_NIL;
+    local->isInt = false;
     if (type != TYPE_FUNCTION) {
         local->name = copyString("this", 4);
     } else {
@@ -176,6 +180,8 @@ static void addLocal(ObjString* name) {
     local->name = name;
     local->depth = -1;
     local->isCaptured = false;
+    local->fixedType = VAL_NIL;
+    local->isInt = false;
 }
 
 static int addUpvalue(Compiler* compiler, uint8_t index, bool isLocal, ObjString* name) {
@@ -215,15 +221,24 @@ static int resolveUpvalue(Compiler* compiler, ObjString* name) {
     return -1;
 }
 
-static uint8_t makeConstant(Value value) {
+static int makeConstant(Value value) {
 
     int constant = addConstant(currentChunk(), value);
-    if (constant > UINT8_MAX) {
+    if (constant > UINT16_MAX) {
         errorAtValue(value, "Too many constants in one chunk.");
         return 0;
     }
 
-    return (uint8_t)constant;
+    return constant;
+}
+
+// An instruction with a constant operand; indices past the first 256 are
+// prefixed with OP_WIDE carrying their high byte.
+static void emitConstantOp(uint8_t op, int constant) {
+    if (constant > UINT8_MAX) {
+        emitBytes(OP_WIDE, (uint8_t)(constant >> 8));
+    }
+    emitBytes(op, (uint8_t)constant);
 }
 
 #define UINT24_MAX 16777215
@@ -253,7 +268,7 @@ static void emitConstant(Value value) {
     }
 
     if (asObject) {
-        emitBytes(OP_CONSTANT, makeConstant(value));
+        emitConstantOp(OP_CONSTANT, makeConstant(value));
     } else {
         emitImmediateConstant(v);
     }
@@ -314,7 +329,7 @@ static void patchJump(int offset) {
     currentChunk()->code[offset + 1] = jump & 0xff;
 }
 
-static uint8_t identifierConstant(ObjString* name) {
+static int identifierConstant(ObjString* name) {
     return makeConstant(OBJ_VAL(name));
 }
 
@@ -336,7 +351,7 @@ static void declareVariable(ObjString* name) {
     addLocal(name);
 }
 
-static uint8_t parseVariable(ObjString* name) {
+static int parseVariable(ObjString* name) {
 
     declareVariable(name);
     if (current->scopeDepth > 0) return 0;
@@ -391,7 +406,61 @@ static void generateExprLogicalOr(ObjExprOperation* bin) {
     patchJump(endJump);
 }
 
+// The last element of *p[i] or *p.f, which the deref can fold into one
+// access so p[i] or p.f never becomes a pointer object of its own.
+static ObjExpr* fusableDerefTail(ObjExpr* chain, ObjExpr** prev) {
+    *prev = NULL;
+    if (chain == NULL || chain->nextExpr == NULL) {
+        return NULL;
+    }
+    ObjExpr* tail = chain;
+    while (tail->nextExpr != NULL) {
+        *prev = tail;
+        tail = tail->nextExpr;
+    }
+    if (tail->obj.type == OBJ_EXPR_COLLECTION_ELEMENT
+        && ((ObjExprCollectionElement*)tail)->assignment == NULL) {
+        return tail;
+    }
+    if (tail->obj.type == OBJ_EXPR_DOT) {
+        ObjExprDot* dot = (ObjExprDot*)tail;
+        if (dot->offset == NULL && dot->assignment == NULL && dot->call == NULL) {
+            return tail;
+        }
+    }
+    return NULL;
+}
+
 static void generateExprAssignable(ObjExprOperation* op) {
+    ObjExpr* prev;
+    ObjExpr* tail = op->operation == EXPR_OP_DEREF_PTR ? fusableDerefTail(op->rhs, &prev) : NULL;
+    if (tail != NULL) {
+        tempRootPush(OBJ_VAL(tail)); // unreachable from the chain while it's cut.
+        prev->nextExpr = NULL;
+        generateExpr(op->rhs);
+        prev->nextExpr = tail;
+        tempRootPop();
+
+        if (tail->obj.type == OBJ_EXPR_COLLECTION_ELEMENT) {
+            generateExpr(((ObjExprCollectionElement*)tail)->element);
+            if (op->assignment) {
+                generateExpr(op->assignment);
+                emitByte(OP_SET_PTR_ELEMENT);
+            } else {
+                emitByte(OP_DEREF_PTR_ELEMENT);
+            }
+        } else {
+            int name = identifierConstant(((ObjExprDot*)tail)->name);
+            if (op->assignment) {
+                generateExpr(op->assignment);
+                emitConstantOp(OP_SET_PTR_PROPERTY, name);
+            } else {
+                emitConstantOp(OP_DEREF_PTR_PROPERTY, name);
+            }
+        }
+        return;
+    }
+
     generateExpr(op->rhs);
     if (op->operation == EXPR_OP_DEREF_PTR
         && op->assignment == NULL) {
@@ -403,8 +472,61 @@ static void generateExprAssignable(ObjExprOperation* op) {
     }
 }
 
+// The slot of the local declared int that expr reads, or -1.
+static int intLocalSlot(ObjExpr* expr) {
+    if (expr == NULL || expr->obj.type != OBJ_EXPR_NAMEDVARIABLE
+        || ((ObjExprNamedVariable*)expr)->assignment != NULL) {
+        return -1;
+    }
+    ObjString* name = ((ObjExprNamedVariable*)expr)->name;
+    for (int i = current->localCount - 1; i >= 0; i--) {
+        Local* local = &current->locals[i];
+        if (identifiersEqual(name, local->name)) {
+            return local->isInt && local->depth != -1 ? i : -1;
+        }
+    }
+    return -1;
+}
+
+// Arithmetic that on an int gives a new ObjInt, or overwrites a temporary one.
+static bool isIntArithmetic(ObjExpr* expr) {
+    if (expr->obj.type != OBJ_EXPR_OPERATION) {
+        return false;
+    }
+    switch (((ObjExprOperation*)expr)->operation) {
+        case EXPR_OP_ADD: case EXPR_OP_SUBTRACT: case EXPR_OP_MULTIPLY:
+        case EXPR_OP_DIVIDE: case EXPR_OP_MODULO:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Binary operations that only read their left operand.
+static bool isReadingOperation(ObjExpr* expr) {
+    if (expr == NULL || expr->obj.type != OBJ_EXPR_OPERATION) {
+        return false;
+    }
+    switch (((ObjExprOperation*)expr)->operation) {
+        case EXPR_OP_EQUAL: case EXPR_OP_NOT_EQUAL:
+        case EXPR_OP_GREATER: case EXPR_OP_GREATER_EQUAL:
+        case EXPR_OP_LESS: case EXPR_OP_LESS_EQUAL:
+        case EXPR_OP_LEFT_SHIFT: case EXPR_OP_RIGHT_SHIFT:
+        case EXPR_OP_BIT_OR: case EXPR_OP_BIT_AND: case EXPR_OP_BIT_XOR:
+            return true;
+        default:
+            return false;
+    }
+}
+
 static void generateArithOperation(ObjExprOperation* op) {    
-    generateExpr(op->rhs);
+    int slot = intLocalSlot(op->rhs);
+    if (slot != -1 && op->rhs->nextExpr == NULL) {
+        // the right operand is only read, the local keeps its ObjInt.
+        emitBytes(OP_GET_LOCAL, (uint8_t)slot);
+    } else {
+        generateExpr(op->rhs);
+    }
 
     switch (op->operation) {
         case EXPR_OP_EQUAL: emitByte(OP_EQUAL); return;
@@ -455,7 +577,7 @@ static void generateGetNamedVariable(ObjString* name) {
         getOp = OP_GET_GLOBAL;
     }
     
-    emitBytes(getOp, (uint8_t)arg);
+    emitConstantOp(getOp, arg);
 }
 
 static void generateExprNamedVariable(ObjExprNamedVariable* var) {
@@ -470,7 +592,7 @@ static void generateExprNamedVariable(ObjExprNamedVariable* var) {
     uint8_t getOp, setOp;
     int arg = resolveLocal(current, var->name);
     if (arg != -1) {
-        getOp = OP_GET_LOCAL;
+        getOp = current->locals[arg].isInt ? OP_GET_LOCAL_INT : OP_GET_LOCAL;
         setOp = OP_SET_LOCAL;
     } else if ((arg = resolveUpvalue(current, var->name)) != -1) {
         getOp = OP_GET_UPVALUE;
@@ -483,9 +605,14 @@ static void generateExprNamedVariable(ObjExprNamedVariable* var) {
     
     if (var->assignment) {
         generateExpr(var->assignment);
-        emitBytes(setOp, (uint8_t)arg);
+        if (setOp == OP_SET_LOCAL && current->locals[arg].fixedType != VAL_NIL) {
+            emitBytes(OP_SET_LOCAL_FIXED, (uint8_t)arg);
+            emitByte((uint8_t)current->locals[arg].fixedType);
+        } else {
+            emitConstantOp(setOp, arg);
+        }
     } else {
-        emitBytes(getOp, (uint8_t)arg);
+        emitConstantOp(getOp, arg);
     }
 }
 
@@ -529,12 +656,12 @@ static void generateExprCollectionInit(ObjExprCollectionInitializer* collection)
             generateExpr(pair->b);
         } else {
             ObjExpr* element = (ObjExpr*)newExprNumberFromCint(i);
-        tempRootPush(OBJ_VAL(element));
+            tempRootPush(OBJ_VAL(element));
             generateExpr(element);
-        generateExpr((ObjExpr*)item_or_pair);
+            generateExpr((ObjExpr*)item_or_pair);
+            tempRootPop();
         }
         emitByte(OP_SET_ELEMENT);
-        tempRootPop();
     }
 }
 
@@ -589,20 +716,20 @@ static void generateExprBuiltin(ObjExprBuiltin* fn) {
 }
 
 static void generateExprDot(ObjExprDot* dot) {
-    uint8_t name = identifierConstant(dot->name);
+    int name = identifierConstant(dot->name);
 
     if (dot->offset) {
         generateExpr(dot->offset);
         emitByte(OP_ADD);
     } else if (dot->assignment) {
         generateExpr(dot->assignment);
-        emitBytes(OP_SET_PROPERTY, name);
+        emitConstantOp(OP_SET_PROPERTY, name);
     } else if (dot->call) {
         generateExprSet(&dot->call->arguments);
-        emitBytes(OP_INVOKE, name);
+        emitConstantOp(OP_INVOKE, name);
         emitByte(dot->call->arguments.objectCount);
     } else {
-        emitBytes(OP_GET_PROPERTY, name);
+        emitConstantOp(OP_GET_PROPERTY, name);
     }
 }
 
@@ -612,7 +739,7 @@ static void generateExprSuper(ObjExprSuper* super) {
     } else if (!currentClass->hasSuperclass) {
         errorAt("super", "Can't use 'super' in a class with no superclass.");
     }
-    uint8_t name = identifierConstant(super->name);
+    int name = identifierConstant(super->name);
 
     ObjString* this_ = copyString("this", 4);
     tempRootPush(OBJ_VAL(this_));
@@ -623,11 +750,11 @@ static void generateExprSuper(ObjExprSuper* super) {
     if (super->call) {
         generateExprSet(&super->call->arguments);
         generateGetNamedVariable(super_);
-        emitBytes(OP_SUPER_INVOKE, name);
+        emitConstantOp(OP_SUPER_INVOKE, name);
         emitByte(super->call->arguments.objectCount);
     } else {
         generateGetNamedVariable(super_);
-        emitBytes(OP_GET_SUPER, name);
+        emitConstantOp(OP_GET_SUPER, name);
     }
 
     tempRootPop();
@@ -760,26 +887,114 @@ static void generateExprElt(ObjExpr* expr) {
     }
 }
 
+// Arithmetic on an int local leaves a new ObjInt that only the next arithmetic
+// in the chain sees, so that may overwrite it in place (OP_INT_TEMPORARY).
 static void generateExpr(ObjExpr* expr) {
+    int slot = intLocalSlot(expr);
+    bool knownInt = slot != -1;
+    bool temporary = false;
+    if (slot != -1) {
+        if (isReadingOperation(expr->nextExpr)) {
+            emitBytes(OP_GET_LOCAL, (uint8_t)slot); // only read, the local keeps its ObjInt.
+        } else {
+            generateExprElt(expr);
+        }
+        expr = expr->nextExpr;
+    }
 
     while (expr != NULL) {
+        bool arithmetic = isIntArithmetic(expr);
+        if (arithmetic && temporary) {
+            emitByte(OP_INT_TEMPORARY);
+        }
         generateExprElt(expr);
+        temporary = arithmetic && knownInt;
+        knownInt = temporary;
         expr = expr->nextExpr;
     }
 }
 
+// Nothing the expression does can assign to a local.
+static bool isSideEffectFree(ObjExpr* expr) {
+    for (; expr != NULL; expr = expr->nextExpr) {
+        switch (expr->obj.type) {
+            case OBJ_EXPR_NUMBER:
+            case OBJ_EXPR_LITERAL:
+            case OBJ_EXPR_STRING:
+                break;
+            case OBJ_EXPR_NAMEDVARIABLE:
+                if (((ObjExprNamedVariable*)expr)->assignment != NULL) return false;
+                break;
+            case OBJ_EXPR_GROUPING:
+                if (!isSideEffectFree(((ObjExprGrouping*)expr)->expression)) return false;
+                break;
+            case OBJ_EXPR_OPERATION: {
+                ObjExprOperation* op = (ObjExprOperation*)expr;
+                if (op->assignment != NULL || !isSideEffectFree(op->rhs)) return false;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// x = x op e; as a statement, for a local x declared int and an e that can't
+// reassign x, becomes e; OP_UPDATE_LOCAL_INT x op.
+static bool generateLocalIntUpdate(ObjExpr* expr) {
+    if (expr->obj.type != OBJ_EXPR_NAMEDVARIABLE || expr->nextExpr != NULL) {
+        return false;
+    }
+    ObjExprNamedVariable* var = (ObjExprNamedVariable*)expr;
+    ObjExpr* lhs = var->assignment;
+    int slot = intLocalSlot(lhs);
+    if (slot == -1 || !identifiersEqual(((ObjExprNamedVariable*)lhs)->name, var->name)) {
+        return false;
+    }
+    ObjExpr* operation = lhs->nextExpr;
+    if (operation == NULL || operation->nextExpr != NULL || !isIntArithmetic(operation)) {
+        return false;
+    }
+    ObjExprOperation* op = (ObjExprOperation*)operation;
+    if (!isSideEffectFree(op->rhs)) {
+        return false;
+    }
+
+    uint8_t arithmetic;
+    switch (op->operation) {
+        case EXPR_OP_ADD: arithmetic = OP_ADD; break;
+        case EXPR_OP_SUBTRACT: arithmetic = OP_SUBTRACT; break;
+        case EXPR_OP_MULTIPLY: arithmetic = OP_MULTIPLY; break;
+        case EXPR_OP_DIVIDE: arithmetic = OP_DIVIDE; break;
+        default: arithmetic = OP_MODULO; break;
+    }
+    generateExpr(op->rhs);
+    emitBytes(OP_UPDATE_LOCAL_INT, (uint8_t)slot);
+    emitByte(arithmetic);
+    return true;
+}
+
+// An expression evaluated for its effect alone.
+static void generateDiscardedExpr(ObjExpr* expr) {
+    if (!generateLocalIntUpdate(expr)) {
+        generateExpr(expr);
+        emitByte(OP_POP);
+    }
+}
+
 static void markInitialized() {
     if (current->scopeDepth == 0) return;
     current->locals[current->localCount - 1].depth = current->scopeDepth;
 }
 
-static void defineVariable(uint8_t global) {
+static void defineVariable(int global) {
     if (current->scopeDepth > 0) {
         markInitialized();
         return;
     }
 
-    emitBytes(OP_DEFINE_GLOBAL, global);
+    emitConstantOp(OP_DEFINE_GLOBAL, global);
 }
 
 static void generateStmtPoke(ObjStmtPoke* stmt) {
@@ -792,8 +1007,35 @@ static void generateStmtPoke(ObjStmtPoke* stmt) {
     emitByte(OP_POKE);
 }
 
+// The local's slot is still a ValueCell, and loads are the plain OP_GET_LOCAL;
+// only stores of a value already of this type skip the checked assignment.
+static ValueType fixedWidthType(ObjExpr* type) {
+    if (type == NULL || type->obj.type != OBJ_EXPR_TYPE || type->nextExpr != NULL) {
+        return VAL_NIL;
+    }
+    switch (((ObjExprTypeLiteral*)type)->type) {
+        case EXPR_TYPE_LITERAL_BOOL: return VAL_BOOL;
+        case EXPR_TYPE_LITERAL_INT8: return VAL_I8;
+        case EXPR_TYPE_LITERAL_UINT8: return VAL_UI8;
+        case EXPR_TYPE_LITERAL_INT16: return VAL_I16;
+        case EXPR_TYPE_LITERAL_UINT16: return VAL_UI16;
+        case EXPR_TYPE_LITERAL_INT32: return VAL_I32;
+        case EXPR_TYPE_LITERAL_UINT32: return VAL_UI32;
+        case EXPR_TYPE_LITERAL_INT64: return VAL_I64;
+        case EXPR_TYPE_LITERAL_UINT64: return VAL_UI64;
+        case EXPR_TYPE_LITERAL_MFLOAT64: return VAL_DOUBLE;
+        default: return VAL_NIL;
+    }
+}
+
 static void generateVarDeclaration(ObjStmtVarDeclaration* decl) {
-    uint8_t global = parseVariable(decl->name);
+    int global = parseVariable(decl->name);
+    if (current->scopeDepth > 0) {
+        Local* local = &current->locals[current->localCount - 1];
+        local->fixedType = fixedWidthType(decl->type);
+        local->isInt = decl->type != NULL && decl->type->obj.type == OBJ_EXPR_TYPE && decl->type->nextExpr == NULL
+            && ((ObjExprTypeLiteral*)decl->type)->type == EXPR_TYPE_LITERAL_INT;
+    }
 
     if (decl->type) {
         generateExpr(decl->type);
@@ -820,7 +1062,7 @@ static void generatePlaceDeclaration(ObjStmtPlaceDeclaration* decl) {
         generateExpr(alias->location);
         emitByte(OP_PLACE);
         
-        uint8_t global = parseVariable(alias->name);
+        int global = parseVariable(alias->name);
         defineVariable(global);
 
     }
@@ -875,7 +1117,7 @@ static void generateFunction(FunctionType type, ObjStmtFunDeclaration* decl) {
     beginScope();
 
     for (int i = 0; i < decl->parameters.objectCount; i++) {
-        uint8_t constant = parseVariable(((ObjExprNamedVariable*)decl->parameters.objects[i])->name);
+        int constant = parseVariable(((ObjExprNamedVariable*)decl->parameters.objects[i])->name);
         defineVariable(constant);
     }
 
@@ -883,7 +1125,7 @@ static void generateFunction(FunctionType type, ObjStmtFunDeclaration* decl) {
 
     ObjFunction* function = endCompiler();
     function->arity = decl->parameters.objectCount;
-    emitBytes(OP_CLOSURE, makeConstant(OBJ_VAL(function)));
+    emitConstantOp(OP_CLOSURE, makeConstant(OBJ_VAL(function)));
 
     for (int i = 0; i < function->upvalueCount; i++) {
         emitByte(compiler.upvalues[i].isLocal ? 1 : 0);
@@ -893,7 +1135,7 @@ static void generateFunction(FunctionType type, ObjStmtFunDeclaration* decl) {
 
 static void generateStmtFunDeclaration(ObjStmtFunDeclaration* decl) {
 
-    uint8_t global = parseVariable(decl->name);
+    int global = parseVariable(decl->name);
     markInitialized();
 
     generateFunction(TYPE_FUNCTION, decl);
@@ -931,6 +1173,21 @@ static void generateStmtYield(ObjStmtExpression* stmt) {
     }
 }
 
+// As generateExpr, but a call ending the expression becomes OP_TAIL_CALL.
+static void generateTailExpr(ObjExpr* expr) {
+    while (expr->nextExpr != NULL) {
+        generateExprElt(expr);
+        expr = expr->nextExpr;
+    }
+    if (expr->obj.type == OBJ_EXPR_CALL) {
+        ObjExprCall* call = (ObjExprCall*)expr;
+        generateExprSet(&call->arguments);
+        emitBytes(OP_TAIL_CALL, call->arguments.objectCount);
+    } else {
+        generateExprElt(expr);
+    }
+}
+
 static void generateStmtReturn(ObjStmtExpression* stmt) {
     if (current->type == TYPE_SCRIPT) {
         errorAt("return", "Can't return from top-level code.");
@@ -943,7 +1200,7 @@ static void generateStmtReturn(ObjStmtExpression* stmt) {
             errorAt("return", "Can't return a value from an initializer.");
         }
 
-        generateExpr(stmt->expression);
+        generateTailExpr(stmt->expression);
         emitByte(OP_RETURN);
     }
 }
@@ -968,8 +1225,7 @@ static void generateStmtFor(ObjStmtFor* loop) {
 
         int bodyJump = emitJump(OP_JUMP);
         int incrementStart = currentChunk()->count;
-        generateExpr(loop->loopExpression);
-        emitByte(OP_POP);
+        generateDiscardedExpr(loop->loopExpression);
 
         emitLoop(loopStart);
         loopStart = incrementStart;
@@ -989,7 +1245,7 @@ static void generateStmtFor(ObjStmtFor* loop) {
 }
 
 static void generateStmtMethodDeclaration(ObjStmtFunDeclaration* method) {
-    uint8_t constant = identifierConstant(method->name);
+    int constant = identifierConstant(method->name);
 
     FunctionType type = TYPE_METHOD;
     ObjString* init = copyString("init", 4);
@@ -1000,15 +1256,15 @@ static void generateStmtMethodDeclaration(ObjStmtFunDeclaration* method) {
     
     generateFunction(type, method);
 
-    emitBytes(OP_METHOD, constant);
+    emitConstantOp(OP_METHOD, constant);
     tempRootPop(); // initi
 }
 
 static void generateStmtClassDeclaration(ObjStmtClassDeclaration* decl) {
-    uint8_t nameConstant = identifierConstant(decl->name);
+    int nameConstant = identifierConstant(decl->name);
     declareVariable(decl->name);
 
-    emitBytes(OP_CLASS, nameConstant);
+    emitConstantOp(OP_CLASS, nameConstant);
     defineVariable(nameConstant);
 
     ClassCompiler classCompiler;
@@ -1048,7 +1304,7 @@ static void generateStmtClassDeclaration(ObjStmtClassDeclaration* decl) {
 static void generateStmtFieldDeclaration(ObjStmtFieldDeclaration* stmt) {
     generateExpr(stmt->type);
     generateExpr(stmt->offset);
-    emitBytes(OP_CONSTANT, makeConstant(OBJ_VAL(stmt->name)));
+    emitConstantOp(OP_CONSTANT, makeConstant(OBJ_VAL(stmt->name)));
 }
 
 static void generateStmt(ObjStmt* stmt) {
@@ -1068,8 +1324,7 @@ static void generateStmt(ObjStmt* stmt) {
     current->recent = stmt;
     switch (stmt->obj.type) {
         case OBJ_STMT_EXPRESSION:
-            generateExpr(((ObjStmtExpression*)stmt)->expression);
-            emitByte(OP_POP);
+            generateDiscardedExpr(((ObjStmtExpression*)stmt)->expression);
             break;
         case OBJ_STMT_PRINT:
             generateExpr(((ObjStmtExpression*)stmt)->expression);
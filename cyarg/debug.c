@@ -53,8 +53,23 @@ static char const *valueType(Value *v) {
     }
 }
 
+// the high byte from a preceding OP_WIDE, taken by the next constant operand.
+static int wideOperand = 0;
+
+static int constantOperand(Chunk* chunk, int offset) {
+    int constant = wideOperand | chunk->code[offset + 1];
+    wideOperand = 0;
+    return constant;
+}
+
+static int wideInstruction(Chunk* chunk, int offset) {
+    wideOperand = chunk->code[offset + 1] << 8;
+    printf("%-16s %4d\n", "OP_WIDE", chunk->code[offset + 1]);
+    return offset + 2;
+}
+
 static int constantInstruction(const char* name, Chunk* chunk, int offset) {
-    uint8_t constant = chunk->code[offset + 1];
+    int constant = constantOperand(chunk, offset);
     printf("%-16s %4d %s:'", name, constant, valueType(&chunk->constants.values[constant]));
     printValue(chunk->constants.values[constant]);
     printf("'\n");
@@ -62,7 +77,7 @@ static int constantInstruction(const char* name, Chunk* chunk, int offset) {
 }
 
 static int invokeInstruction(const char* name, Chunk* chunk, int offset) {
-    uint8_t constant = chunk->code[offset + 1];
+    int constant = constantOperand(chunk, offset);
     uint8_t argCount = chunk->code[offset + 2];
     printf("%-16s (%d args) %4d:'", name, argCount, constant);
     printValue(chunk->constants.values[constant]);
@@ -81,6 +96,13 @@ static int byteInstruction(const char* name, Chunk* chunk, int offset) {
     return offset + 2;
 }
 
+static int slotTypeInstruction(const char* name, Chunk* chunk, int offset) {
+    uint8_t slot = chunk->code[offset + 1];
+    uint8_t type = chunk->code[offset + 2];
+    printf("%-16s %4d %4d\n", name, slot, type);
+    return offset + 3;
+}
+
 static int twoByteInstruction(const char* name, Chunk* chunk, int offset) {
     uint16_t slot = chunk->code[offset + 1];
     slot += chunk->code[offset + 2] * 256;
@@ -263,8 +285,8 @@ int disassembleInstruction(Chunk* chunk, int offset) {
         case OP_SUPER_INVOKE:
             return invokeInstruction("OP_SUPER_INVOKE", chunk, offset);
         case OP_CLOSURE: {
-            offset++;
-            uint8_t constant = chunk->code[offset++];
+            int constant = constantOperand(chunk, offset);
+            offset += 2;
             printf("%-16s %4d ", "OP_CLOSURE", constant);
             printValue(chunk->constants.values[constant]);
             printf("\n");
@@ -320,8 +342,28 @@ int disassembleInstruction(Chunk* chunk, int offset) {
             return simpleInstruction("OP_DEREF_PTR", offset);
         case OP_SET_PTR_TARGET:
             return simpleInstruction("OP_SET_PTR_TARGET", offset);
+        case OP_DEREF_PTR_ELEMENT:
+            return simpleInstruction("OP_DEREF_PTR_ELEMENT", offset);
+        case OP_SET_PTR_ELEMENT:
+            return simpleInstruction("OP_SET_PTR_ELEMENT", offset);
+        case OP_DEREF_PTR_PROPERTY:
+            return constantInstruction("OP_DEREF_PTR_PROPERTY", chunk, offset);
+        case OP_SET_PTR_PROPERTY:
+            return constantInstruction("OP_SET_PTR_PROPERTY", chunk, offset);
+        case OP_WIDE:
+            return wideInstruction(chunk, offset);
         case OP_PLACE:
             return simpleInstruction("OP_PLACE", offset);
+        case OP_SET_LOCAL_FIXED:
+            return slotTypeInstruction("OP_SET_LOCAL_FIXED", chunk, offset);
+        case OP_TAIL_CALL:
+            return byteInstruction("OP_TAIL_CALL", chunk, offset);
+        case OP_INT_TEMPORARY:
+            return simpleInstruction("OP_INT_TEMPORARY", offset);
+        case OP_GET_LOCAL_INT:
+            return byteInstruction("OP_GET_LOCAL_INT", chunk, offset);
+        case OP_UPDATE_LOCAL_INT:
+            return slotTypeInstruction("OP_UPDATE_LOCAL_INT", chunk, offset);
         default:
             printf("Unknown opcode %d\n", instruction);
             return offset + 1;
@@ -5,9 +5,30 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+// Called once from initVMMemory, before either core touches a file.
+void initFileSystem();
+
 char* readFile(const char* path);
 size_t fileSize(const char* path);
 void readFileIntoBuffer(const char* path, uint8_t* buffer, size_t bufferSize);
+// Maps a file copy-on-write for the rest of the process, or NULL when the
+// filesystem can't, in which case read it with readFileIntoBuffer instead.
+uint8_t* mapFile(const char* path, size_t* size);
+void unmapFile(uint8_t* mapped, size_t size);
 bool fileExists(const char* path);
 
+// Streaming access, for files too big to hold in memory. A handle is an index
+// into a small table of open files; fileOpen returns -1 when the file can't be
+// opened or the table is full. Modes are the fopen ones: r, r+, w, w+, a, a+.
+// Read and write return the bytes moved, or -1 on error; a short read is the
+// end of the file. Seek is from the start and returns the new position.
+#define FILE_HANDLES_MAX 4
+
+int fileOpen(const char* path, const char* mode);
+int32_t fileRead(int handle, uint8_t* buffer, size_t size);
+int32_t fileWrite(int handle, const uint8_t* buffer, size_t size);
+int32_t fileSeek(int handle, uint32_t position);
+bool fileClose(int handle);
+bool fileHandleOpen(int handle);
+
 #endif
@@ -1,46 +1,182 @@
+#include <string.h>
+
 #include "../../external/littlefs/lfs.h"
 #include "pico_lfs_hal.h"
 #include "pico_flash_fs.h"
+#include "fs.h"
+#include "../platform_hal.h"
 #include "../print.h"
 
+// cache needs to be a multiple of the programming page size. Reads come from
+// uncached flash, so two pages lets littlefs pull a directory entry and its
+// neighbours in one pass.
+#define FLASHFS_CACHE_SIZE (PICO_PROG_PAGE_SIZE * 2)
+
+// one bit per block, so a single lookahead scan covers the whole filesystem.
+#define FLASHFS_LOOKAHEAD_SIZE (FLASHFS_BLOCK_COUNT / 8)
+
+static uint8_t readCache[FLASHFS_CACHE_SIZE];
+static uint8_t progCache[FLASHFS_CACHE_SIZE];
+static uint8_t fileCache[FLASHFS_CACHE_SIZE];
+// littlefs wants the lookahead buffer 32-bit aligned.
+static uint32_t lookahead[FLASHFS_LOOKAHEAD_SIZE / sizeof(uint32_t)];
+
 static struct lfs_config cfg = {
     .read = pico_read_flash_block,
     .prog  = pico_prog_flash_block,
     .erase = pico_erase_flash_block,
     .sync  = pico_sync_flash_block,
-    
+
     // block device configuration
 
     // device is memory mapped for reading, so reading can be per byte
     .read_size = 1,
-    
+
     .prog_size = PICO_PROG_PAGE_SIZE,
     .block_size = PICO_ERASE_PAGE_SIZE,
 
     // the number of blocks we use for a flash fs.
     .block_count = FLASHFS_BLOCK_COUNT,
 
-    // cache needs to be a multiple of the programming page size.
-    .cache_size = PICO_PROG_PAGE_SIZE * 1,
-
-    .lookahead_size = 16,
+    .cache_size = FLASHFS_CACHE_SIZE,
+    .lookahead_size = FLASHFS_LOOKAHEAD_SIZE,
     .block_cycles = 500,
+
+    // static buffers, so littlefs never calls malloc.
+    .read_buffer = readCache,
+    .prog_buffer = progCache,
+    .lookahead_buffer = lookahead,
 };
 
+// Whole-file reads open and close their file under fsLock, so they share one cache.
+static struct lfs_file_config fileCfg = {
+    .buffer = fileCache,
+};
+
+// The filesystem is mounted on first use and stays mounted, so its caches
+// stay warm between calls. fsLock serialises both cores through it.
+static lfs_t lfs;
+static bool mounted = false;
+static platform_mutex fsLock;
+
+// import() and the boot script stat the same few paths over and over - the
+// .yb, then the .ya, then the size before the read. Remember the last few.
+#define STAT_CACHE_ENTRIES 4
+#define STAT_CACHE_PATH_MAX 64
+
+typedef struct {
+    bool valid;
+    int err;
+    uint8_t type;
+    lfs_size_t size;
+    char path[STAT_CACHE_PATH_MAX];
+} CachedStat;
+
+static CachedStat statCache[STAT_CACHE_ENTRIES];
+static int statCacheNext = 0;
+
+// Streamed files stay open between calls, so each has its own cache.
+typedef struct {
+    bool open;
+    lfs_file_t file;
+    struct lfs_file_config cfg;
+    uint8_t cache[FLASHFS_CACHE_SIZE];
+} StreamedFile;
+
+static StreamedFile openFiles[FILE_HANDLES_MAX];
+
+void initFileSystem() {
+    platform_mutex_init(&fsLock);
+}
+
+static bool enterFileSystem() {
+    platform_mutex_enter(&fsLock);
+    if (!mounted) {
+        int err = lfs_mount(&lfs, &cfg);
+        if (err < 0) {
+            FPRINTMSG(stderr, "Could not mount filesystem (%d).\n", err);
+            platform_mutex_leave(&fsLock);
+            return false;
+        }
+        mounted = true;
+    }
+    return true;
+}
+
+static void leaveFileSystem() {
+    platform_mutex_leave(&fsLock);
+}
+
+static int statPath(const char* path, uint8_t* type, lfs_size_t* size) {
+    size_t length = strlen(path);
+    bool cacheable = length < STAT_CACHE_PATH_MAX;
+
+    if (cacheable) {
+        for (int i = 0; i < STAT_CACHE_ENTRIES; i++) {
+            CachedStat* entry = &statCache[i];
+            if (entry->valid && strcmp(entry->path, path) == 0) {
+                *type = entry->type;
+                *size = entry->size;
+                return entry->err;
+            }
+        }
+    }
+
+    struct lfs_info info;
+    memset(&info, 0, sizeof(info));
+    int err = lfs_stat(&lfs, path, &info);
+    *type = info.type;
+    *size = info.size;
+
+    if (cacheable) {
+        CachedStat* entry = &statCache[statCacheNext];
+        statCacheNext = (statCacheNext + 1) % STAT_CACHE_ENTRIES;
+        entry->valid = true;
+        entry->err = err;
+        entry->type = info.type;
+        entry->size = info.size;
+        memcpy(entry->path, path, length + 1);
+    }
+    return err;
+}
+
+// Anything that writes may change what a stat would say.
+static void forgetStats() {
+    for (int i = 0; i < STAT_CACHE_ENTRIES; i++) {
+        statCache[i].valid = false;
+    }
+}
+
+// Reads a whole regular file of known size; the caller holds fsLock.
+static bool readWholeFile(const char* path, void* buffer, lfs_size_t size) {
+    lfs_file_t file;
+    memset(&file, 0, sizeof(file));
+
+    int err = lfs_file_opencfg(&lfs, &file, path, LFS_O_RDONLY, &fileCfg);
+    if (err < 0) {
+        FPRINTMSG(stderr, "Could not open file \"%s\".\n", path);
+        return false;
+    }
+
+    lfs_ssize_t bytesRead = lfs_file_read(&lfs, &file, buffer, size);
+    lfs_file_close(&lfs, &file);
+
+    if (bytesRead < 0 || (lfs_size_t)bytesRead < size) {
+        FPRINTMSG(stderr, "could not read file \"%s\".\n", path);
+        return false;
+    }
+    return true;
+}
+
 static void lsDir(const char* path) {
-    lfs_t lfs;
     lfs_dir_t dir;
-    memset(&lfs, 0, sizeof(lfs));
     memset(&dir, 0, sizeof(dir));
-    
-    // mount the filesystem
-    int err = lfs_mount(&lfs, &cfg);
-    if (err < 0) {
-        FPRINTMSG(stderr, "Could not mount filesystem (%d).\n", err);
+
+    if (!enterFileSystem()) {
         exit(74);
     }
 
-    err = lfs_dir_open(&lfs, &dir, path);
+    int err = lfs_dir_open(&lfs, &dir, path);
     if (err < 0) {
         FPRINTMSG(stderr, "Could not open dir \"%s\" (%d).\n", path, err);
         exit(74);
@@ -64,143 +200,191 @@ static void lsDir(const char* path) {
     }
 
     lfs_dir_close(&lfs, &dir);
-    lfs_unmount(&lfs);
-
+    leaveFileSystem();
 }
 
 char* readFile(const char* path) {
-
-    lfs_t lfs;
-    lfs_file_t file;
-    memset(&lfs, 0, sizeof(lfs));
-    memset(&file, 0, sizeof(file));
-    
-    // mount the filesystem
-    int err = lfs_mount(&lfs, &cfg);
-    if (err < 0) {
-        FPRINTMSG(stderr, "Could not mount filesystem (%d).\n", err);
+    if (!enterFileSystem()) {
         return NULL;
     }
-    struct lfs_info info;
-    memset(&info, 0, sizeof(info));
 
-    err = lfs_stat(&lfs, path, &info);
-    if (err < 0) {
+    uint8_t type;
+    lfs_size_t fileSize;
+    if (statPath(path, &type, &fileSize) < 0 || type != LFS_TYPE_REG) {
+        leaveFileSystem();
         return NULL;
     }
-    int fileSize = info.size;
 
     char* buffer = (char*)malloc(fileSize + 1);
     if (buffer == NULL) {
         FPRINTMSG(stderr, "Not enough memory to read \"%s\".\n", path);
+        leaveFileSystem();
         return NULL;
     }
 
-    err = lfs_file_open(&lfs, &file, path, LFS_O_RDONLY);
-    if (err < 0) {
-        FPRINTMSG(stderr, "Could not open file \"%s\".\n", path);
-        return NULL;
-    }
-
-    int bytesRead = lfs_file_read(&lfs, &file, buffer, fileSize);
-    if (bytesRead < fileSize) {
-        FPRINTMSG(stderr, "could not read file \"%s\".\n", path);
+    if (!readWholeFile(path, buffer, fileSize)) {
+        free(buffer);
+        leaveFileSystem();
         return NULL;
     }
-    buffer[bytesRead] = '\0';
-    
-    lfs_file_close(&lfs, &file);    
-    lfs_unmount(&lfs);
+    buffer[fileSize] = '\0';
 
+    leaveFileSystem();
     return buffer;
 }
 
 size_t fileSize(const char* path) {
-    lfs_t lfs;
-    memset(&lfs, 0, sizeof(lfs));
-    
-    // mount the filesystem
-    int err = lfs_mount(&lfs, &cfg);
-    if (err < 0) {
-        FPRINTMSG(stderr, "Could not mount filesystem (%d).\n", err);
+    if (!enterFileSystem()) {
         return 0;
     }
-    struct lfs_info info;
-    memset(&info, 0, sizeof(info));
 
-    err = lfs_stat(&lfs, path, &info);
+    uint8_t type;
+    lfs_size_t size;
+    int err = statPath(path, &type, &size);
+    leaveFileSystem();
+
     if (err < 0) {
         return 0;
     }
-    int fileSize = info.size;
-
-    lfs_unmount(&lfs);
-
-    return fileSize;
+    return size;
 }
 
 void readFileIntoBuffer(const char* path, uint8_t* buffer, size_t bufferSize) {
-    lfs_t lfs;
-    lfs_file_t file;
-    memset(&lfs, 0, sizeof(lfs));
-    memset(&file, 0, sizeof(file));
-    
-    // mount the filesystem
-    int err = lfs_mount(&lfs, &cfg);
-    if (err < 0) {
-        FPRINTMSG(stderr, "Could not mount filesystem (%d).\n", err);
+    if (!enterFileSystem()) {
         return;
     }
-    struct lfs_info info;
-    memset(&info, 0, sizeof(info));
 
-    err = lfs_stat(&lfs, path, &info);
-    if (err < 0) {
+    uint8_t type;
+    lfs_size_t fileSize;
+    if (statPath(path, &type, &fileSize) < 0) {
+        leaveFileSystem();
         return;
     }
-    int fileSize = info.size;
 
     if (fileSize > bufferSize) {
         FPRINTMSG(stderr, "Buffer too small to read file \"%s\".\n", path);
+        leaveFileSystem();
         return;
     }
 
-    err = lfs_file_open(&lfs, &file, path, LFS_O_RDONLY);
-    if (err < 0) {
-        FPRINTMSG(stderr, "Could not open file \"%s\".\n", path);
-        return;
-    }
+    readWholeFile(path, buffer, fileSize);
+    leaveFileSystem();
+}
 
-    int bytesRead = lfs_file_read(&lfs, &file, buffer, fileSize);
-    if (bytesRead < fileSize) {
-        FPRINTMSG(stderr, "could not read file \"%s\".\n", path);
-        return;
-    }
-    
-    lfs_file_close(&lfs, &file);    
-    lfs_unmount(&lfs);
+uint8_t* mapFile(const char* path, size_t* size) {
+    // littlefs files are not contiguous in flash, so there is nothing to map.
+    return NULL;
+}
+
+void unmapFile(uint8_t* mapped, size_t size) {
 }
 
 bool fileExists(const char* path) {
-    lfs_t lfs;
-    memset(&lfs, 0, sizeof(lfs));
-    
-    // mount the filesystem
-    int err = lfs_mount(&lfs, &cfg);
+    if (!enterFileSystem()) {
+        return false;
+    }
+
+    uint8_t type;
+    lfs_size_t size;
+    int err = statPath(path, &type, &size);
+    leaveFileSystem();
+
     if (err < 0) {
-        FPRINTMSG(stderr, "Could not mount filesystem (%d).\n", err);
         return false;
     }
-    struct lfs_info info;
-    memset(&info, 0, sizeof(info));
 
-    err = lfs_stat(&lfs, path, &info);
+    return type == LFS_TYPE_REG;
+}
 
-    lfs_unmount(&lfs);
+static int openFlags(const char* mode) {
+    if (strcmp(mode, "r") == 0) {
+        return LFS_O_RDONLY;
+    } else if (strcmp(mode, "r+") == 0) {
+        return LFS_O_RDWR;
+    } else if (strcmp(mode, "w") == 0) {
+        return LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC;
+    } else if (strcmp(mode, "w+") == 0) {
+        return LFS_O_RDWR | LFS_O_CREAT | LFS_O_TRUNC;
+    } else if (strcmp(mode, "a") == 0) {
+        return LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND;
+    } else if (strcmp(mode, "a+") == 0) {
+        return LFS_O_RDWR | LFS_O_CREAT | LFS_O_APPEND;
+    }
+    return 0;
+}
 
-    if (err < 0) {
+int fileOpen(const char* path, const char* mode) {
+    int flags = openFlags(mode);
+    if (flags == 0 || !enterFileSystem()) {
+        return -1;
+    }
+
+    for (int handle = 0; handle < FILE_HANDLES_MAX; handle++) {
+        StreamedFile* streamed = &openFiles[handle];
+        if (!streamed->open) {
+            memset(&streamed->file, 0, sizeof(streamed->file));
+            memset(&streamed->cfg, 0, sizeof(streamed->cfg));
+            streamed->cfg.buffer = streamed->cache;
+
+            int err = lfs_file_opencfg(&lfs, &streamed->file, path, flags, &streamed->cfg);
+            if (flags != LFS_O_RDONLY) {
+                forgetStats();
+            }
+            // claim the handle before another core can scan for a free one.
+            streamed->open = err >= 0;
+            leaveFileSystem();
+
+            return err < 0 ? -1 : handle;
+        }
+    }
+
+    leaveFileSystem();
+    return -1;
+}
+
+bool fileHandleOpen(int handle) {
+    return handle >= 0 && handle < FILE_HANDLES_MAX && openFiles[handle].open;
+}
+
+int32_t fileRead(int handle, uint8_t* buffer, size_t size) {
+    if (!enterFileSystem()) {
+        return -1;
+    }
+    lfs_ssize_t bytesRead = lfs_file_read(&lfs, &openFiles[handle].file, buffer, size);
+    leaveFileSystem();
+
+    return bytesRead < 0 ? -1 : bytesRead;
+}
+
+int32_t fileWrite(int handle, const uint8_t* buffer, size_t size) {
+    if (!enterFileSystem()) {
+        return -1;
+    }
+    lfs_ssize_t bytesWritten = lfs_file_write(&lfs, &openFiles[handle].file, buffer, size);
+    forgetStats();
+    leaveFileSystem();
+
+    return bytesWritten < 0 ? -1 : bytesWritten;
+}
+
+int32_t fileSeek(int handle, uint32_t position) {
+    if (!enterFileSystem()) {
+        return -1;
+    }
+    lfs_soff_t offset = lfs_file_seek(&lfs, &openFiles[handle].file, position, LFS_SEEK_SET);
+    leaveFileSystem();
+
+    return offset < 0 ? -1 : offset;
+}
+
+bool fileClose(int handle) {
+    if (!enterFileSystem()) {
         return false;
     }
+    int err = lfs_file_close(&lfs, &openFiles[handle].file);
+    openFiles[handle].open = false;
+    forgetStats();
+    leaveFileSystem();
 
-    return info.type == LFS_TYPE_REG;
-}
\ No newline at end of file
+    return err >= 0;
+}
@@ -1,10 +1,18 @@
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "fs.h"
 #include "../print.h"
 
+void initFileSystem() {
+}
+
 char* readFile(const char* path) {
     FILE* file = fopen(path, "rb");
     if (file == NULL) {
@@ -78,6 +86,33 @@ void readFileIntoBuffer(const char* path, uint8_t* buffer, size_t bufferSize) {
     fclose(file);
 }
 
+uint8_t* mapFile(const char* path, size_t* size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    // Private, so writes to the array land in this process's copy and never the file.
+    void* mapped = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return NULL;
+    }
+
+    *size = st.st_size;
+    return (uint8_t*)mapped;
+}
+
+void unmapFile(uint8_t* mapped, size_t size) {
+    munmap(mapped, size);
+}
+
 bool fileExists(const char* path) {
     FILE* file = fopen(path, "rb");
     if (file == NULL) {
@@ -86,4 +121,70 @@ bool fileExists(const char* path) {
         fclose(file);
         return true;
     }
-}
\ No newline at end of file
+}
+
+static FILE* openFiles[FILE_HANDLES_MAX];
+
+int fileOpen(const char* path, const char* mode) {
+    static const char* modes[] = { "r", "r+", "w", "w+", "a", "a+" };
+    char binaryMode[4];
+    binaryMode[0] = '\0';
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (strcmp(mode, modes[i]) == 0) {
+            snprintf(binaryMode, sizeof(binaryMode), "%sb", mode);
+        }
+    }
+    if (binaryMode[0] == '\0') {
+        return -1;
+    }
+
+    for (int handle = 0; handle < FILE_HANDLES_MAX; handle++) {
+        if (openFiles[handle] == NULL) {
+            openFiles[handle] = fopen(path, binaryMode);
+            return openFiles[handle] == NULL ? -1 : handle;
+        }
+    }
+    return -1;
+}
+
+bool fileHandleOpen(int handle) {
+    return handle >= 0 && handle < FILE_HANDLES_MAX && openFiles[handle] != NULL;
+}
+
+int32_t fileRead(int handle, uint8_t* buffer, size_t size) {
+    FILE* file = openFiles[handle];
+    size_t bytesRead = fread(buffer, sizeof(uint8_t), size, file);
+    if (bytesRead < size && ferror(file)) {
+        clearerr(file);
+        return -1;
+    }
+    return bytesRead;
+}
+
+int32_t fileWrite(int handle, const uint8_t* buffer, size_t size) {
+    FILE* file = openFiles[handle];
+    size_t bytesWritten = fwrite(buffer, sizeof(uint8_t), size, file);
+    if (bytesWritten < size) {
+        clearerr(file);
+        return -1;
+    }
+    return bytesWritten;
+}
+
+int32_t fileSeek(int handle, uint32_t position) {
+    // Positions past INT32_MAX can't be reported back, nor passed to a 32-bit long.
+    if (position > INT32_MAX) {
+        return -1;
+    }
+    // Seeking also lets a file opened for update switch between reading and writing.
+    if (fseek(openFiles[handle], position, SEEK_SET) != 0) {
+        return -1;
+    }
+    return position;
+}
+
+bool fileClose(int handle) {
+    int err = fclose(openFiles[handle]);
+    openFiles[handle] = NULL;
+    return err == 0;
+}
@@ -1,6 +1,13 @@
 #include <stdlib.h>
+#include <stdint.h>
 #include <sysexits.h>
 #include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 
 #include "common.h"
 #include "hosted.h"
@@ -52,7 +59,126 @@ int runHostedFile(const char* libraryPath, const char* path) {
     }
 }
 
-int compileFile(const char* path, const char* outputPath) {
+// A request is a uint32 length then that many bytes of zero terminated arguments,
+// sent with the client's stdin, stdout and stderr attached. The reply is the
+// int32 exit code, or 128 plus the signal that ended the run.
+#define SERVE_FDS 3
+#define SERVE_ARGS_MAX 64
+
+static bool readFully(int fd, void* buffer, size_t length) {
+    uint8_t* at = buffer;
+    while (length > 0) {
+        ssize_t n = read(fd, at, length);
+        if (n <= 0) return false;
+        at += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static bool receiveRequest(int connection, uint32_t* length, int fds[SERVE_FDS]) {
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof (int) * SERVE_FDS)];
+    } control;
+    struct iovec iov = { .iov_base = length, .iov_len = sizeof *length };
+    struct msghdr message = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = &control, .msg_controllen = sizeof control };
+
+    ssize_t n = recvmsg(connection, &message, 0);
+    if (n <= 0) return false;
+
+    struct cmsghdr* attached = CMSG_FIRSTHDR(&message);
+    if (attached == NULL || attached->cmsg_level != SOL_SOCKET || attached->cmsg_type != SCM_RIGHTS
+        || attached->cmsg_len != CMSG_LEN(sizeof (int) * SERVE_FDS)) {
+        return false;
+    }
+    memcpy(fds, CMSG_DATA(attached), sizeof (int) * SERVE_FDS);
+
+    return readFully(connection, (uint8_t*)length + n, sizeof *length - (size_t)n);
+}
+
+// Runs in a fork of the server, so that the run itself can be forked again and
+// its end, however it comes, reported.
+static void handleRequest(int connection, const char* program, HostedCommand run) {
+    uint32_t length;
+    int fds[SERVE_FDS] = { -1, -1, -1 };
+    if (!receiveRequest(connection, &length, fds)) return;
+
+    char* arguments = malloc(length + 1);
+    if (!readFully(connection, arguments, length)) return;
+    arguments[length] = '\0';
+
+    const char* argv[SERVE_ARGS_MAX + 1] = { program };
+    int argc = 1;
+    for (char* at = arguments; at < arguments + length && argc < SERVE_ARGS_MAX; at += strlen(at) + 1) {
+        argv[argc++] = at;
+    }
+    argv[argc] = NULL;
+
+    pid_t worker = fork();
+    if (worker == 0) {
+        close(connection);
+        for (int i = 0; i < SERVE_FDS; i++) {
+            dup2(fds[i], i);
+            close(fds[i]);
+        }
+        exit(run(argc, argv));
+    }
+    for (int i = 0; i < SERVE_FDS; i++) {
+        close(fds[i]);
+    }
+
+    int32_t code = EX_OSERR;
+    int status;
+    if (worker > 0 && waitpid(worker, &status, 0) == worker) {
+        code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    }
+    write(connection, &code, sizeof code);
+}
+
+int serveRequests(const char* program, const char* socketPath, HostedCommand run) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(socketPath) >= sizeof address.sun_path) {
+        fprintf(stderr, "Socket path too long '%s'.\n", socketPath);
+        return EX_USAGE;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    // a stale socket from an earlier server is replaced, anything else is left alone
+    struct stat existing;
+    if (lstat(socketPath, &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            fprintf(stderr, "Not replacing '%s', it isn't a socket.\n", socketPath);
+            return EX_CANTCREAT;
+        }
+        unlink(socketPath);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof address) != 0 || listen(listener, SOMAXCONN) != 0) {
+        perror("cyarg --serve");
+        return EX_OSERR;
+    }
+
+    // handlers are reaped as they exit, each waiting on its own run
+    signal(SIGCHLD, SIG_IGN);
+
+    while (true) {
+        int connection = accept(listener, NULL, NULL);
+        if (connection < 0) continue;
+
+        pid_t handler = fork();
+        if (handler == 0) {
+            close(listener);
+            signal(SIGCHLD, SIG_DFL);
+            handleRequest(connection, program, run);
+            _exit(EX_OK);
+        }
+        close(connection);
+    }
+}
+
+int compileFile(const char* path, const char* outputPath, bool aot, bool compress) {
 
     ObjString* pathString = copyString(path, (int) strlen(path));
     tempRootPush(OBJ_VAL(pathString));
@@ -68,7 +194,12 @@ int compileFile(const char* path, const char* outputPath) {
         exitCode = EX_DATAERR;
     } else {
         if (outputPath && IS_CLOSURE(compilerResult)) {
-            exitCode = packScript(path, AS_CLOSURE(compilerResult)->function, true, outputPath);
+            exitCode = packScript(path, AS_CLOSURE(compilerResult)->function, true, aot, compress, outputPath);
+            if (exitCode == EX_UNAVAILABLE) {
+                fputs("Ahead of time packages need cyarg built with CYARG_FEATURE_JIT.\n", stderr);
+            } else if (exitCode == EX_DATAERR) {
+                fprintf(stderr, "Can't pack %s: its constants or code reach past the 16MiB a package can address.\n", path);
+            }
         }
     }
 
@@ -7,12 +7,16 @@ typedef struct {
     int argc;
     const char** argv;
     int exitCode;
+    const char* cachePath;
 } Host;
 
 extern Host vmHost;
 
+typedef int (*HostedCommand)(int argc, const char* argv[]);
+
 int runHostedFile(const char* libraryPath, const char* path);
-int compileFile(const char* path, const char* outputPath);
+int serveRequests(const char* program, const char* socketPath, HostedCommand run);
+int compileFile(const char* path, const char* outputPath, bool aot, bool compress);
 int disassembleFile(const char* path);
 int loadPackageFile(const char *path);
 
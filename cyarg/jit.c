@@ -0,0 +1,493 @@
+#include <stdlib.h>
+
+#include "common.h"
+
+#include "jit.h"
+#include "memory.h"
+#include "vm.h"
+
+// Threaded templates for hot functions.
+//
+// No machine code is emitted: each bytecode instruction is translated once
+// into a JitOp naming a C template for its common case, with the operands
+// already decoded and jump targets resolved to op indexes, and jitRun()
+// calls one template after another. Templates cover the local, constant,
+// comparison, arithmetic and branch instructions that dominate tight loops;
+// anything else, or a template whose operands are not of the expected types,
+// exits with frame->ip on the instruction so run() interprets it as usual.
+
+static bool isFalsey(Value value) {
+    return IS_NIL(value) || (IS_BOOL(value) && !AS_BOOL(value));
+}
+
+static int instructionLength(Chunk const* chunk, int offset) {
+    switch (chunk->code[offset]) {
+        case OP_CONSTANT:
+        case OP_GET_BUILTIN:
+        case OP_GET_LOCAL:
+        case OP_GET_LOCAL_INT:
+        case OP_SET_LOCAL:
+        case OP_GET_GLOBAL:
+        case OP_DEFINE_GLOBAL:
+        case OP_SET_GLOBAL:
+        case OP_GET_UPVALUE:
+        case OP_SET_UPVALUE:
+        case OP_GET_PROPERTY:
+        case OP_SET_PROPERTY:
+        case OP_DEREF_PTR_PROPERTY:
+        case OP_SET_PTR_PROPERTY:
+        case OP_GET_SUPER:
+        case OP_CALL:
+        case OP_TAIL_CALL:
+        case OP_CLASS:
+        case OP_METHOD:
+        case OP_IMMEDIATE_P8:
+        case OP_IMMEDIATE_N8:
+        case OP_TYPE_LITERAL:
+        case OP_TYPE_STRUCT:
+            return 2;
+        case OP_JUMP:
+        case OP_JUMP_IF_FALSE:
+        case OP_LOOP:
+        case OP_INVOKE:
+        case OP_SUPER_INVOKE:
+        case OP_IMMEDIATE_P16:
+        case OP_IMMEDIATE_N16:
+        case OP_SET_LOCAL_FIXED:
+        case OP_UPDATE_LOCAL_INT:
+            return 3;
+        case OP_IMMEDIATE_P24:
+        case OP_IMMEDIATE_N24:
+            return 4;
+        case OP_CLOSURE: {
+            ObjFunction* function = AS_FUNCTION(chunk->constants.values[chunk->code[offset + 1]]);
+            return 2 + 2 * function->upvalueCount;
+        }
+        case OP_WIDE: {
+            // left to the interpreter together with the instruction it prefixes.
+            if (chunk->code[offset + 2] == OP_CLOSURE) {
+                int constant = (chunk->code[offset + 1] << 8) | chunk->code[offset + 3];
+                ObjFunction* function = AS_FUNCTION(chunk->constants.values[constant]);
+                return 4 + 2 * function->upvalueCount;
+            }
+            return 2 + instructionLength(chunk, offset + 2);
+        }
+        default:
+            return 1;
+    }
+}
+
+static int jitConstant(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    push(routine, frame->closure->function->chunk.constants.values[op->operand]);
+    return op->next;
+}
+
+static int jitImmediate(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    ObjInt* i = newIntU(op->operand < 0 ? -op->operand : op->operand);
+    i->isLiteral = true;
+    i->bigInt.neg_ = op->operand < 0;
+    push(routine, OBJ_VAL(i));
+    return op->next;
+}
+
+static int jitNil(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    push(routine, NIL_VAL);
+    return op->next;
+}
+
+static int jitTrue(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    push(routine, BOOL_VAL(true));
+    return op->next;
+}
+
+static int jitFalse(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    push(routine, BOOL_VAL(false));
+    return op->next;
+}
+
+static int jitPop(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    pop(routine);
+    return op->next;
+}
+
+static int jitGetLocal(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    push(routine, frameSlot(routine, frame, op->operand)->value);
+    return op->next;
+}
+
+static int jitGetLocalInt(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    Value value = frameSlot(routine, frame, op->operand)->value;
+    disownInt(value);
+    push(routine, value);
+    return op->next;
+}
+
+// operand is the slot in the low byte and the arithmetic opcode above it.
+static int jitUpdateLocalInt(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    if (!updateLocalInt(routine, frame, op->operand & 0xff, op->operand >> 8)) {
+        return JIT_EXIT;
+    }
+    return op->next;
+}
+
+static int jitIntTemporary(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    Value temporary = peek(routine, 0);
+    if (IS_INT(temporary) && !AS_INTOBJ(temporary)->isLiteral) {
+        AS_INTOBJ(temporary)->isTemporary = true;
+    }
+    return op->next;
+}
+
+static int jitSetLocal(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    ValueCell* lhs = frameSlot(routine, frame, op->operand);
+    ValueCellTarget lhsTrg = { .cellType = lhs->cellType, .value = &lhs->value };
+
+    if (!assignToValueCellTarget(lhsTrg, peek(routine, 0))) {
+        return JIT_EXIT;
+    }
+    return op->next;
+}
+
+// operand is the slot in the low byte and the declared ValueType above it.
+static int jitSetLocalFixed(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    ValueCell* lhs = frameSlot(routine, frame, op->operand & 0xff);
+    Value rhs = peek(routine, 0);
+
+    if (rhs.type != (ValueType)(op->operand >> 8)) {
+        return JIT_EXIT;
+    }
+    lhs->value = rhs;
+    return op->next;
+}
+
+static int jitGetUpvalue(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    Value value = frame->closure->upvalues[op->operand]->contents->value;
+    disownInt(value);
+    push(routine, value);
+    return op->next;
+}
+
+static int jitGetGlobal(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    ObjString* name = AS_STRING(frame->closure->function->chunk.constants.values[op->operand]);
+    ValueCell cell;
+    platform_mutex_enter(&vm.env);
+    bool found = tableCellGet(&vm.globals, name, &cell);
+    platform_mutex_leave(&vm.env);
+    if (!found) {
+        return JIT_EXIT;
+    }
+    push(routine, cell.value);
+    return op->next;
+}
+
+#define JIT_ARITH(name, op, intOp) \
+    static int name(ObjRoutine* routine, CallFrame* frame, JitOp* jop) { \
+        Value b = peek(routine, 0); \
+        Value a = peek(routine, 1); \
+        if (IS_I32(a) && IS_I32(b)) { \
+            routine->stackTopIndex -= 2; \
+            push(routine, I32_VAL(AS_I32(a) op AS_I32(b))); \
+        } else if (IS_DOUBLE(a) && IS_DOUBLE(b)) { \
+            routine->stackTopIndex -= 2; \
+            push(routine, DOUBLE_VAL(AS_DOUBLE(a) op AS_DOUBLE(b))); \
+        } else if (IS_INT(a) && IS_INT(b)) { \
+            binaryIntOp(routine, intOp); \
+        } else { \
+            return JIT_EXIT; \
+        } \
+        return jop->next; \
+    }
+
+JIT_ARITH(jitAdd, +, "+")
+JIT_ARITH(jitSubtract, -, "-")
+JIT_ARITH(jitMultiply, *, "*")
+
+#define JIT_COMPARE(name, op, intOp) \
+    static int name(ObjRoutine* routine, CallFrame* frame, JitOp* jop) { \
+        Value b = peek(routine, 0); \
+        Value a = peek(routine, 1); \
+        if (IS_INT(a) && IS_INT(b)) { \
+            binaryIntBoolOp(routine, intOp); \
+        } else if (IS_I32(a) && IS_I32(b)) { \
+            routine->stackTopIndex -= 2; \
+            push(routine, BOOL_VAL(AS_I32(a) op AS_I32(b))); \
+        } else if (IS_DOUBLE(a) && IS_DOUBLE(b)) { \
+            routine->stackTopIndex -= 2; \
+            push(routine, BOOL_VAL(AS_DOUBLE(a) op AS_DOUBLE(b))); \
+        } else { \
+            return JIT_EXIT; \
+        } \
+        return jop->next; \
+    }
+
+JIT_COMPARE(jitEqual, ==, "==")
+JIT_COMPARE(jitGreater, >, ">")
+JIT_COMPARE(jitLess, <, "<")
+
+// An immediate followed by arithmetic or a comparison on an int is fused
+// into one template, so the immediate never becomes a heap ObjInt.
+#define JIT_IMMEDIATE_ARITH(name, intOp) \
+    static int name(ObjRoutine* routine, CallFrame* frame, JitOp* jop) { \
+        if (!IS_INT(peek(routine, 0))) return JIT_EXIT; \
+        IntConcrete4 immediate; \
+        int_set_i(jop->operand, int_init_concrete4(&immediate)); \
+        ObjInt* r = intArithmetic(AS_INTOBJ(peek(routine, 0)), (Int*) &immediate, intOp); \
+        pop(routine); \
+        push(routine, OBJ_VAL(r)); \
+        return jop->next; \
+    }
+
+JIT_IMMEDIATE_ARITH(jitImmediateAdd, '+')
+JIT_IMMEDIATE_ARITH(jitImmediateSubtract, '-')
+
+#define JIT_IMMEDIATE_COMPARE(name, comp) \
+    static int name(ObjRoutine* routine, CallFrame* frame, JitOp* jop) { \
+        if (!IS_INT(peek(routine, 0))) return JIT_EXIT; \
+        IntConcrete4 immediate; \
+        int_set_i(jop->operand, int_init_concrete4(&immediate)); \
+        bool r = int_is(AS_INT(pop(routine)), (Int*) &immediate) == comp; \
+        push(routine, BOOL_VAL(r)); \
+        return jop->next; \
+    }
+
+JIT_IMMEDIATE_COMPARE(jitImmediateEqual, INT_EQ)
+JIT_IMMEDIATE_COMPARE(jitImmediateGreater, INT_GT)
+JIT_IMMEDIATE_COMPARE(jitImmediateLess, INT_LT)
+
+#undef JIT_ARITH
+#undef JIT_COMPARE
+#undef JIT_IMMEDIATE_ARITH
+#undef JIT_IMMEDIATE_COMPARE
+
+static JitTemplate fusedImmediate(uint8_t instruction) {
+    switch (instruction) {
+        case OP_ADD: return jitImmediateAdd;
+        case OP_SUBTRACT: return jitImmediateSubtract;
+        case OP_EQUAL: return jitImmediateEqual;
+        case OP_GREATER: return jitImmediateGreater;
+        case OP_LESS: return jitImmediateLess;
+        default: return NULL;
+    }
+}
+
+static int jitNot(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    push(routine, BOOL_VAL(isFalsey(pop(routine))));
+    return op->next;
+}
+
+static int jitJump(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    return op->next;
+}
+
+static int jitJumpIfFalse(ObjRoutine* routine, CallFrame* frame, JitOp* op) {
+    return isFalsey(peek(routine, 0)) ? op->operand : op->next;
+}
+
+static JitCode* translate(ObjFunction const* function) {
+    Chunk const* chunk = &function->chunk;
+    int32_t* entry = ALLOCATE(int32_t, chunk->count + 1);
+    int count = 0;
+    for (int offset = 0; offset < chunk->count;) {
+        int length = instructionLength(chunk, offset);
+        entry[offset] = count++;
+        for (int i = 1; i < length && offset + i < chunk->count; i++) {
+            entry[offset + i] = -1;
+        }
+        offset += length;
+    }
+    entry[chunk->count] = count;
+
+    JitOp* ops = ALLOCATE(JitOp, count + 1);
+    int index = 0;
+    for (int offset = 0; offset < chunk->count; index++) {
+        uint8_t* code = &chunk->code[offset];
+        int length = instructionLength(chunk, offset);
+        JitOp* op = &ops[index];
+        op->exec = NULL;
+        op->offset = offset;
+        op->operand = 0;
+        op->next = index + 1;
+
+        switch (code[0]) {
+            case OP_CONSTANT:
+                if (code[1] < chunk->constants.count) {
+                    op->exec = jitConstant;
+                    op->operand = code[1];
+                }
+                break;
+            case OP_IMMEDIATE_P8: op->exec = jitImmediate; op->operand = code[1]; break;
+            case OP_IMMEDIATE_N8: op->exec = jitImmediate; op->operand = -code[1]; break;
+            case OP_IMMEDIATE_P16: op->exec = jitImmediate; op->operand = code[1] + 256 * code[2]; break;
+            case OP_IMMEDIATE_N16: op->exec = jitImmediate; op->operand = -(code[1] + 256 * code[2]); break;
+            case OP_IMMEDIATE_P24: op->exec = jitImmediate; op->operand = code[1] + 256 * code[2] + 65536 * code[3]; break;
+            case OP_IMMEDIATE_N24: op->exec = jitImmediate; op->operand = -(code[1] + 256 * code[2] + 65536 * code[3]); break;
+            case OP_NIL: op->exec = jitNil; break;
+            case OP_TRUE: op->exec = jitTrue; break;
+            case OP_FALSE: op->exec = jitFalse; break;
+            case OP_POP: op->exec = jitPop; break;
+            case OP_GET_LOCAL: op->exec = jitGetLocal; op->operand = code[1]; break;
+            case OP_SET_LOCAL: op->exec = jitSetLocal; op->operand = code[1]; break;
+            case OP_SET_LOCAL_FIXED: op->exec = jitSetLocalFixed; op->operand = code[1] | (code[2] << 8); break;
+            case OP_GET_LOCAL_INT: op->exec = jitGetLocalInt; op->operand = code[1]; break;
+            case OP_UPDATE_LOCAL_INT: op->exec = jitUpdateLocalInt; op->operand = code[1] | (code[2] << 8); break;
+            case OP_INT_TEMPORARY: op->exec = jitIntTemporary; break;
+            case OP_GET_UPVALUE:
+                if (code[1] < function->upvalueCount) {
+                    op->exec = jitGetUpvalue;
+                    op->operand = code[1];
+                }
+                break;
+            case OP_GET_GLOBAL:
+                if (code[1] < chunk->constants.count && IS_STRING(chunk->constants.values[code[1]])) {
+                    op->exec = jitGetGlobal;
+                    op->operand = code[1];
+                }
+                break;
+            case OP_ADD: op->exec = jitAdd; break;
+            case OP_SUBTRACT: op->exec = jitSubtract; break;
+            case OP_MULTIPLY: op->exec = jitMultiply; break;
+            case OP_EQUAL: op->exec = jitEqual; break;
+            case OP_GREATER: op->exec = jitGreater; break;
+            case OP_LESS: op->exec = jitLess; break;
+            case OP_NOT: op->exec = jitNot; break;
+            case OP_JUMP:
+            case OP_JUMP_IF_FALSE:
+            case OP_LOOP: {
+                int jump = (code[1] << 8) | code[2];
+                int target = offset + 3 + (code[0] == OP_LOOP ? -jump : jump);
+                if (target < 0 || target > chunk->count || entry[target] < 0) {
+                    break; // malformed, leave it to the interpreter.
+                }
+                if (code[0] == OP_JUMP_IF_FALSE) {
+                    op->exec = jitJumpIfFalse;
+                    op->operand = entry[target];
+                } else {
+                    op->exec = jitJump;
+                    op->next = entry[target];
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        if (op->exec == jitImmediate && offset + length < chunk->count) {
+            JitTemplate fused = fusedImmediate(chunk->code[offset + length]);
+            if (fused != NULL) {
+                op->exec = fused;
+                op->next = index + 2;
+            }
+        }
+        offset += length;
+    }
+
+    // sentinel so that a function never runs off the end of its ops.
+    ops[count] = (JitOp){ .exec = NULL, .offset = chunk->count, .operand = 0, .next = count };
+
+    JitCode* jit = ALLOCATE(JitCode, 1);
+    jit->count = count;
+    jit->ops = ops;
+    jit->entry = entry;
+    jit->entryCount = chunk->count + 1;
+    return jit;
+}
+
+// Reached only by the call that made the function hot; published under vm.jit.
+void jitCompile(ObjFunction* function) {
+    platform_mutex_enter(&vm.jit);
+    if (function->jit == NULL) {
+        __atomic_store_n(&function->jit, translate(function), __ATOMIC_RELEASE);
+    }
+    platform_mutex_leave(&vm.jit);
+}
+
+// Templates in the order of their packed ids, 0 being the interpreter.
+static JitTemplate const packedTemplates[] = {
+    NULL,
+    jitConstant, jitImmediate, jitNil, jitTrue, jitFalse, jitPop,
+    jitGetLocal, jitSetLocal, jitGetUpvalue, jitGetGlobal,
+    jitAdd, jitSubtract, jitMultiply, jitEqual, jitGreater, jitLess,
+    jitImmediateAdd, jitImmediateSubtract,
+    jitImmediateEqual, jitImmediateGreater, jitImmediateLess,
+    jitNot, jitJump, jitJumpIfFalse, jitSetLocalFixed,
+    jitGetLocalInt, jitUpdateLocalInt, jitIntTemporary
+};
+
+#define NUM_PACKED_TEMPLATES (sizeof packedTemplates / sizeof packedTemplates[0])
+
+_Static_assert(NUM_PACKED_TEMPLATES == JIT_PACKED_TEMPLATES, "packed template ids are part of the package format");
+
+int jitPack(ObjFunction const* function, JitPackedOp** packed) {
+    JitCode* jit = translate(function);
+
+    JitPackedOp* ops = malloc(sizeof (JitPackedOp) * jit->count);
+    for (int i = 0; i < jit->count; i++) {
+        uint8_t id = 0;
+        while (id < NUM_PACKED_TEMPLATES && packedTemplates[id] != jit->ops[i].exec) id++;
+        ops[i] = (JitPackedOp){
+            .template_ = id < NUM_PACKED_TEMPLATES ? id : 0,
+            .offset_ = jit->ops[i].offset,
+            .next_ = (uint32_t)jit->ops[i].next,
+            .operand_ = jit->ops[i].operand
+        };
+    }
+
+    int count = jit->count;
+    freeJitCode(jit);
+    *packed = ops;
+    return count;
+}
+
+// The packed ops are trusted no further than the bytecode they were packed from: the
+// function is translated afresh and bound only if every op agrees, so a stale or
+// damaged section is ignored and the function warms up in the interpreter as usual.
+bool jitBindPacked(ObjFunction* function, JitPackedOp const* packed, int count) {
+    JitCode* jit = translate(function);
+
+    bool same = jit->count == count;
+    for (int i = 0; same && i < count; i++) {
+        JitOp const* op = &jit->ops[i];
+        same = packed[i].template_ < NUM_PACKED_TEMPLATES
+            && packedTemplates[packed[i].template_] == op->exec
+            && packed[i].offset_ == op->offset
+            && packed[i].next_ == (uint32_t)op->next
+            && packed[i].operand_ == op->operand;
+    }
+    if (!same) {
+        freeJitCode(jit);
+        return false;
+    }
+
+    platform_mutex_enter(&vm.jit);
+    if (function->jit == NULL) {
+        __atomic_store_n(&function->jit, jit, __ATOMIC_RELEASE);
+        jit = NULL;
+    }
+    platform_mutex_leave(&vm.jit);
+    if (jit != NULL) {
+        freeJitCode(jit);
+    }
+    return true;
+}
+
+void jitRun(ObjRoutine* routine, CallFrame* frame) {
+    ObjFunction* function = frame->closure->function;
+    JitCode* jit = jitCode(function);
+
+    int pc = jit->entry[frame->ip - function->chunk.code];
+    if (pc < 0) return;
+
+    JitOp* op = &jit->ops[pc];
+    while (op->exec != NULL) {
+        int next = op->exec(routine, frame, op);
+        if (next == JIT_EXIT) break;
+        op = &jit->ops[next];
+    }
+    frame->ip = function->chunk.code + op->offset;
+}
+
+void freeJitCode(JitCode* code) {
+    if (code == NULL) return;
+    FREE_ARRAY(JitOp, code->ops, code->count + 1);
+    FREE_ARRAY(int32_t, code->entry, code->entryCount);
+    FREE(JitCode, code);
+}
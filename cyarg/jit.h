@@ -0,0 +1,66 @@
+#ifndef cyarg_jit_h
+#define cyarg_jit_h
+
+#include "object.h"
+#include "routine.h"
+
+// Number of calls through callfn() before a function is translated.
+#define JIT_HOT_THRESHOLD 64
+
+// returned by a template to hand the current instruction back to run().
+#define JIT_EXIT -1
+
+typedef struct JitOp JitOp;
+
+typedef int (*JitTemplate)(ObjRoutine* routine, CallFrame* frame, JitOp* op);
+
+struct JitOp {
+    JitTemplate exec;   // NULL if the instruction is left to the interpreter.
+    uint32_t offset;    // bytecode offset of the instruction.
+    int32_t operand;
+    int32_t next;       // op index of the following or jump target instruction.
+};
+
+typedef struct JitCode {
+    int count;
+    JitOp* ops;
+    int32_t* entry;     // bytecode offset to op index, -1 inside operands.
+    int entryCount;
+} JitCode;
+
+// Templates a packed op can name, 0 being the interpreter. The ids are part of the
+// package format: adding, removing or reordering templates needs a packageVersion bump.
+#define JIT_PACKED_TEMPLATES 29
+
+// A JitOp as stored in the aot section of a package, the template given by id.
+typedef struct JitPackedOp {
+    uint8_t template_;
+    uint8_t reserved_;
+    uint16_t reserved2_;
+    uint32_t offset_;
+    uint32_t next_;
+    int32_t operand_;
+} JitPackedOp;
+
+// A function's translation, NULL until it's hot. Published whole, as a routine
+// on the other core may be calling the function too.
+static inline JitCode* jitCode(ObjFunction const* function) {
+    return __atomic_load_n(&function->jit, __ATOMIC_ACQUIRE);
+}
+
+void jitCompile(ObjFunction* function);
+
+// Counts a call to a function not yet translated; only the call that makes it
+// hot goes on to translate it, so the common case takes no lock.
+static inline void jitCountCall(ObjFunction* function) {
+    if (__atomic_add_fetch(&function->callCount, 1, __ATOMIC_RELAXED) == JIT_HOT_THRESHOLD) {
+        jitCompile(function);
+    }
+}
+
+int jitPack(ObjFunction const* function, JitPackedOp** packed);
+bool jitBindPacked(ObjFunction* function, JitPackedOp const* packed, int count);
+void jitRun(ObjRoutine* routine, CallFrame* frame);
+void freeJitCode(JitCode* code);
+
+#endif
@@ -32,8 +32,23 @@ void usageMessage(FILE* destination) {
           "\tCompile a Yarg script, reporting any compilation errors.\n"
           "\t\tOptionally output a binary script to <output>.\n"
           "\n"
+          "\tcyarg --compile-aot <path> <output>\n"
+          "\tCompile a Yarg script to a binary script at <output>, including\n"
+          "\t\tthe templated code that functions are bound to when loaded.\n"
+          "\n"
+          "\tcyarg --compile-compressed <path> <output>\n"
+          "\tCompile a Yarg script to a compressed binary script at <output>,\n"
+          "\t\tunpacked into memory when loaded.\n"
+          "\n"
           "\tcyarg --disassemble <path>\n"
           "\tDisassemble a Yarg script, displaying the generated bytecode.\n"
+          "\n"
+          "\tcyarg --serve <socket>\n"
+          "\tServe requests on the Unix socket at <socket>, running the arguments\n"
+          "\t\teach carries in a fork of this initialised cyarg.\n"
+          "\n"
+          "\tWith YARG_CACHE set to a directory, scripts compiled by compile() and\n"
+          "\t\tload() are cached there, keyed by their source, and loaded on reuse.\n"
          , destination);
 }
 
@@ -64,22 +79,13 @@ int main() {
     return 0;
 }
 #elif defined(CYARG_FEATURE_HOSTED_REPL)
-int main(int argc, const char* argv[]) {
-    platform_hal_init();
-
-    if (argv[1] && strcmp(argv[1], "--help") == 0) {
-        usageMessage(stdout);
-        return EX_OK;
-    }
-
-    initVMMemory();
-
+static int runCommand(int argc, const char* argv[]) {
     const char* libPath = getArgument(argc, argv, "--lib");
 
-    initVMRuntime();
     vmHost.argc = argc;
     vmHost.argv = argv;
     vmHost.exitCode = EX_OK;
+    vmHost.cachePath = getenv("YARG_CACHE");
     if (libPath) {
         vm.libraryPath = copyString(libPath, (int)strlen(libPath));
     }
@@ -87,9 +93,13 @@ int main(int argc, const char* argv[]) {
     int returnCode = EX_OK;
 
     if ((argv[1] && strcmp(argv[1], "--compile") == 0) && argc == 3) {
-        returnCode = compileFile(argv[2], NULL);
+        returnCode = compileFile(argv[2], NULL, false, false);
     } else if ((argv[1] && strcmp(argv[1], "--compile") == 0) && argc == 4) {
-        returnCode = compileFile(argv[2], argv[3]);
+        returnCode = compileFile(argv[2], argv[3], false, false);
+    } else if ((argv[1] && strcmp(argv[1], "--compile-aot") == 0) && argc == 4) {
+        returnCode = compileFile(argv[2], argv[3], true, false);
+    } else if ((argv[1] && strcmp(argv[1], "--compile-compressed") == 0) && argc == 4) {
+        returnCode = compileFile(argv[2], argv[3], false, true);
     } else if ((argv[1] && strcmp(argv[1], "--bootstrap") == 0) && argc == 3) {
         returnCode = runHostedFile(NULL, argv[2]);
     } else if (argc == 3 && strcmp(argv[1], "--disassemble") == 0) {
@@ -110,6 +120,27 @@ int main(int argc, const char* argv[]) {
         returnCode = EX_USAGE;
     }
 
+    return returnCode;
+}
+
+int main(int argc, const char* argv[]) {
+    platform_hal_init();
+
+    if (argv[1] && strcmp(argv[1], "--help") == 0) {
+        usageMessage(stdout);
+        return EX_OK;
+    }
+
+    initVMMemory();
+    initVMRuntime();
+
+    int returnCode;
+    if (argc == 3 && strcmp(argv[1], "--serve") == 0) {
+        returnCode = serveRequests(argv[0], argv[2], runCommand);
+    } else {
+        returnCode = runCommand(argc, argv);
+    }
+
     freeVM();
     return returnCode;
 }
@@ -0,0 +1,189 @@
+#include "common.h"
+
+#include "map.h"
+
+#include "memory.h"
+#include "vm.h"
+#include "yargtype.h"
+
+static bool isIntegerKeyed(ObjMap* map) {
+    return map->type->key_type->yt != TypeString;
+}
+
+static void keyRange(ObjConcreteYargType* keyType, int64_t* min, uint64_t* max) {
+    switch (keyType->yt) {
+        case TypeInt8: *min = INT8_MIN; *max = INT8_MAX; break;
+        case TypeUint8: *min = 0; *max = UINT8_MAX; break;
+        case TypeInt16: *min = INT16_MIN; *max = INT16_MAX; break;
+        case TypeUint16: *min = 0; *max = UINT16_MAX; break;
+        case TypeInt32: *min = INT32_MIN; *max = INT32_MAX; break;
+        case TypeUint32: *min = 0; *max = UINT32_MAX; break;
+        case TypeInt64: *min = INT64_MIN; *max = INT64_MAX; break;
+        default: *min = 0; *max = UINT64_MAX; break;
+    }
+}
+
+// Any integer, or address, that the key type can hold is a key.
+static bool integerKey(ObjConcreteYargType* keyType, Value key, uint64_t* bits) {
+    int64_t min;
+    uint64_t max;
+    keyRange(keyType, &min, &max);
+
+    int64_t s = 0;
+    uint64_t u = 0;
+    bool isSigned = false;
+    switch (key.type) {
+        case VAL_I8: s = AS_I8(key); isSigned = true; break;
+        case VAL_I16: s = AS_I16(key); isSigned = true; break;
+        case VAL_I32: s = AS_I32(key); isSigned = true; break;
+        case VAL_I64: s = AS_I64(key); isSigned = true; break;
+        case VAL_UI8: u = AS_UI8(key); break;
+        case VAL_UI16: u = AS_UI16(key); break;
+        case VAL_UI32: u = AS_UI32(key); break;
+        case VAL_UI64: u = AS_UI64(key); break;
+        case VAL_ADDRESS: u = AS_ADDRESS(key); break;
+        case VAL_OBJ: {
+            if (!IS_INT(key) || int_is_range(AS_INT(key), min, max) != INT_WITHIN) {
+                return false;
+            }
+            *bits = min < 0 ? (uint64_t)int_to_i64(AS_INT(key)) : int_to_u64(AS_INT(key));
+            return true;
+        }
+        default:
+            return false;
+    }
+
+    if (isSigned) {
+        if (s < min || (s > 0 && (uint64_t)s > max)) return false;
+        *bits = (uint64_t)s;
+    } else {
+        if (u > max) return false;
+        *bits = u;
+    }
+    return true;
+}
+
+static Value keyValue(ObjConcreteYargType* keyType, uint64_t bits) {
+    switch (keyType->yt) {
+        case TypeInt8: return I8_VAL((int8_t)bits);
+        case TypeUint8: return UI8_VAL((uint8_t)bits);
+        case TypeInt16: return I16_VAL((int16_t)bits);
+        case TypeUint16: return UI16_VAL((uint16_t)bits);
+        case TypeInt32: return I32_VAL((int32_t)bits);
+        case TypeUint32: return UI32_VAL((uint32_t)bits);
+        case TypeInt64: return I64_VAL((int64_t)bits);
+        default: return UI64_VAL(bits);
+    }
+}
+
+bool mapGet(ObjRoutine* routine, ObjMap* map, Value key, Value* value) {
+    bool found;
+    if (isIntegerKeyed(map)) {
+        uint64_t bits;
+        if (!integerKey(map->type->key_type, key, &bits)) {
+            runtimeError(routine, "Expected a key of the map's key type.");
+            return false;
+        }
+        found = integerTableGet(&map->integers, bits, value);
+    } else {
+        if (!IS_STRING(key)) {
+            runtimeError(routine, "Expected a string key.");
+            return false;
+        }
+        found = tableGet(&map->entries, AS_STRING(key), value);
+    }
+    if (!found) {
+        *value = NIL_VAL;
+    }
+    return true;
+}
+
+bool mapSet(ObjRoutine* routine, ObjMap* map, Value key, Value value) {
+    if (isIntegerKeyed(map)) {
+        uint64_t bits;
+        if (!integerKey(map->type->key_type, key, &bits)) {
+            runtimeError(routine, "Expected a key of the map's key type.");
+            return false;
+        }
+        integerTableSet(&map->integers, bits, value);
+    } else {
+        if (!IS_STRING(key)) {
+            runtimeError(routine, "Expected a string key for map assignment.");
+            return false;
+        }
+        tableSet(&map->entries, AS_STRING(key), value);
+    }
+    return true;
+}
+
+size_t mapCount(ObjMap* map) {
+    return isIntegerKeyed(map) ? map->integers.count : map->entries.count;
+}
+
+bool map_reserveNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+    Value mapVal = nativeArgument(routine, argCount, 0);
+    Value countVal = nativeArgument(routine, argCount, 1);
+    if (!IS_MAP(mapVal) || !is_positive_integer32(countVal)) {
+        runtimeError(routine, "Expected a map and a positive integer.");
+        return false;
+    }
+
+    ObjMap* map = AS_MAP(mapVal);
+    int count = (int)as_positive_integer32(countVal);
+    if (isIntegerKeyed(map)) {
+        integerTableReserve(&map->integers, count);
+    } else {
+        tableReserve(&map->entries, count);
+    }
+    *result = NIL_VAL;
+    return true;
+}
+
+// An any[] of the keys, in no particular order, or nil for an empty map.
+bool map_keysNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 1) {
+        runtimeError(routine, "Expected 1 argument but got %d.", argCount);
+        return false;
+    }
+    Value mapVal = nativeArgument(routine, argCount, 0);
+    if (!IS_MAP(mapVal)) {
+        runtimeError(routine, "Expected a map.");
+        return false;
+    }
+
+    ObjMap* map = AS_MAP(mapVal);
+    size_t count = mapCount(map);
+    if (count == 0) {
+        *result = NIL_VAL;
+        return true;
+    }
+
+    ObjConcreteYargTypeArray* keysType = (ObjConcreteYargTypeArray*) newYargArrayTypeFromType(NIL_VAL, count, 0);
+    tempRootPush(OBJ_VAL(keysType));
+    ObjPackedUniformArray* keys = newPackedUniformArray(keysType);
+    tempRootPop();
+
+    size_t next = 0;
+    if (isIntegerKeyed(map)) {
+        for (int i = 0; i < map->integers.capacity; i++) {
+            IntegerEntry* entry = &map->integers.entries[i];
+            if (entry->used) {
+                assignToPackedValue(arrayElement(keys->store, next++), keyValue(map->type->key_type, entry->key));
+            }
+        }
+    } else {
+        for (int i = 0; i < map->entries.capacity; i++) {
+            Entry* entry = &map->entries.entries[i];
+            if (entry->key != NULL) {
+                assignToPackedValue(arrayElement(keys->store, next++), OBJ_VAL(entry->key));
+            }
+        }
+    }
+
+    *result = OBJ_VAL(keys);
+    return true;
+}
@@ -0,0 +1,16 @@
+#ifndef cyarg_map_h
+#define cyarg_map_h
+
+#include "object.h"
+
+// Maps are specialised by key type: strings key the ValueTable, fixed width
+// integers (and addresses) key an IntegerTable by their bits.
+
+bool mapGet(ObjRoutine* routine, ObjMap* map, Value key, Value* value);
+bool mapSet(ObjRoutine* routine, ObjMap* map, Value key, Value value);
+size_t mapCount(ObjMap* map);
+
+bool map_reserveNative(ObjRoutine* routine, int argCount, Value* result);
+bool map_keysNative(ObjRoutine* routine, int argCount, Value* result);
+
+#endif
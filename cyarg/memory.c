@@ -9,6 +9,11 @@
 #include "channel.h"
 #include "sync_group.h"
 #include "platform_hal.h"
+#include "pack.h"
+#include "fs/fs.h"
+#ifdef CYARG_FEATURE_JIT
+#include "jit.h"
+#endif
 
 #ifdef DEBUG_LOG_GC
 #include "debug.h"
@@ -69,7 +74,11 @@ Value tempRootPop() {
 
 void markObject(Obj* object) {
     if (object == NULL) return;
-    if (object->isMarked) return;
+    if (object->isMarked) {
+        // a package constant is always marked, but keeps its package loaded
+        if (object->isPermanent) markPackageOf(object);
+        return;
+    }
 
 #ifdef DEBUG_LOG_GC
     PRINTERR("%p mark ", (void*)object);
@@ -157,6 +166,7 @@ static void blackenObject(Obj* object) {
             ObjFunction* function = (ObjFunction*)object;
             markObject((Obj*)function->fName);
             markArray(&function->chunk.constants);
+            markPackage(function->package);
             break;
         }
         case OBJ_INSTANCE: {
@@ -190,6 +200,7 @@ static void blackenObject(Obj* object) {
             /* fall through */
         case OBJ_PACKEDUNIFORMARRAY: {
             ObjPackedUniformArray* array = (ObjPackedUniformArray*)object;
+            markObject(array->owner);
             markPackedValue(array->store);
             break;
         }
@@ -212,6 +223,7 @@ static void blackenObject(Obj* object) {
             ObjMap* map = (ObjMap*)object;
             markObject((Obj*)map->type);
             markTable(&map->entries);
+            markIntegerTable(&map->integers);
             break;
         }
         case OBJ_YARGTYPE: break;
@@ -224,7 +236,7 @@ static void blackenObject(Obj* object) {
             ObjConcreteYargTypeStruct* type = (ObjConcreteYargTypeStruct*)object;
             markTable(&type->field_names);
             for (int i = 0; i < type->field_count; i++) {
-                ObjConcreteYargType* field_type = type->field_types[i];
+                ObjConcreteYargType* field_type = type->fields[i].type;
                 markObject((Obj*)field_type);
             }
             break;
@@ -467,6 +479,9 @@ static void freeObject(Obj* object) {
         case OBJ_FUNCTION: {
             ObjFunction* function = (ObjFunction*)object;
             freeChunk(&function->chunk);
+#ifdef CYARG_FEATURE_JIT
+            freeJitCode(function->jit);
+#endif
             FREE(ObjFunction, object);
             break;
         }
@@ -478,6 +493,7 @@ static void freeObject(Obj* object) {
         }
         case OBJ_NATIVE: FREE(ObjNative, object); break;
         case OBJ_ROUTINE:
+            freeRoutineFrames((ObjRoutine*)object);
             FREE(ObjRoutine, object);
             break;
         case OBJ_STRING: {
@@ -496,12 +512,18 @@ static void freeObject(Obj* object) {
             FREE(ObjPackedPointer, object); 
             break;
         }
-        case OBJ_UNOWNED_UNIFORMARRAY: FREE(ObjPackedUniformArray, object); break;
+        case OBJ_UNOWNED_UNIFORMARRAY: {
+            ObjPackedUniformArray* array = (ObjPackedUniformArray*)object;
+            if (array->mapped > 0) {
+                unmapFile((uint8_t*)array->store.storedValue, array->mapped);
+            }
+            FREE(ObjPackedUniformArray, object);
+            break;
+        }
         case OBJ_PACKEDUNIFORMARRAY: {
             ObjPackedUniformArray* array = (ObjPackedUniformArray*)object;
             ObjConcreteYargTypeArray* arrayType = (ObjConcreteYargTypeArray*)array->store.storedType;
-            size_t element_size = arrayElementSize(arrayType);
-            array->store.storedValue = reallocate(array->store.storedValue, arrayType->cardinality * element_size, 0);
+            array->store.storedValue = reallocate(array->store.storedValue, arrayStorageSize(arrayType), 0);
             FREE(ObjPackedUniformArray, object);
             break;
         }
@@ -515,6 +537,7 @@ static void freeObject(Obj* object) {
         case OBJ_MAP: {
             ObjMap* map = (ObjMap*)object;
             freeTable(&map->entries);
+            freeIntegerTable(&map->integers);
             FREE(ObjMap, object);
             break;
         }
@@ -522,8 +545,8 @@ static void freeObject(Obj* object) {
         case OBJ_YARGTYPE_ARRAY: FREE(ObjConcreteYargTypeArray, object); break;
         case OBJ_YARGTYPE_STRUCT: {
             ObjConcreteYargTypeStruct* t = (ObjConcreteYargTypeStruct*)object;
-            FREE_ARRAY(ObjConcreteYargType*, t->field_types, t->field_count);
-            FREE_ARRAY(size_t, t->field_indexes, t->field_count);
+            FREE_ARRAY(StructFieldLayout, t->fields, t->field_count);
+            FREE_ARRAY(uint32_t, t->reference_fields, REFERENCE_BITMAP_WORDS(t->field_count));
             freeTable(&t->field_names);
             FREE(ObjConcreteYargTypeStruct, object);
             break;
@@ -595,7 +618,12 @@ static void freeObject(Obj* object) {
             break;
         }
         case OBJ_EXPR_TYPE_INDEXED_COLLECTION: FREE(ObjExprTypeIndexedCollection, object); break;
-        case OBJ_INT: FREE(ObjInt, object); break;
+        case OBJ_INT: {
+            // give back the digits allocateIntObject() counted, not just the header.
+            ObjInt* i = (ObjInt*)object;
+            reallocate(object, sizeof(ObjInt) + i->bigInt.m_ * sizeof(uint16_t), 0);
+            break;
+        }
     }
 }
 
@@ -611,9 +639,44 @@ static void traceReferences() {
     }
 }
 
+static bool isTypeObject(Obj* object) {
+    switch (object->type) {
+        case OBJ_YARGTYPE:
+        case OBJ_YARGTYPE_ARRAY:
+        case OBJ_YARGTYPE_STRUCT:
+        case OBJ_YARGTYPE_POINTER:
+        case OBJ_YARGTYPE_MAP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Freeing packed storage sizes it from its type, and types are shared, so a
+// dead type is only freed once everything dead that might describe it is.
+static void freeObjectsTypesLast(Obj* object) {
+    Obj* types = NULL;
+    while (object != NULL) {
+        Obj* next = object->next;
+        if (isTypeObject(object)) {
+            object->next = types;
+            types = object;
+        } else {
+            freeObject(object);
+        }
+        object = next;
+    }
+    while (types != NULL) {
+        Obj* next = types->next;
+        freeObject(types);
+        types = next;
+    }
+}
+
 static void sweep() {
     Obj* previous = NULL;
     Obj* object = vm.objects;
+    Obj* unreachable = NULL;
     while (object != NULL) {
         if (object->isMarked) {
             object->isMarked = false;
@@ -628,9 +691,11 @@ static void sweep() {
                 vm.objects = object;
             }
 
-            freeObject(unreached);
+            unreached->next = unreachable;
+            unreachable = unreached;
         }
     }
+    freeObjectsTypesLast(unreachable);
 }
 
 void collectGarbage() {
@@ -644,7 +709,9 @@ void collectGarbage() {
 
     markRoots();
     traceReferences();
+    sweepPackages();
     tableRemoveWhite(&vm.strings);
+    yargTypeTableRemoveWhite(&vm.types);
     sweep();
 
     size_t candidateGC = vm.bytesAllocated * GC_HEAP_GROW_FACTOR;
@@ -661,12 +728,8 @@ void collectGarbage() {
 }
 
 void freeObjects() {
-    Obj* object = vm.objects;
-    while (object != NULL) {
-        Obj* next = object->next;
-        freeObject(object);
-        object = next;
-    }
+    freeObjectsTypesLast(vm.objects);
+    vm.objects = NULL;
 
     free(vm.grayStack);
 }
@@ -7,6 +7,7 @@
 #include "native.h"
 #include "routine.h"
 #include "vm.h"
+#include "yargtype.h"
 #include "fs/fs.h"
 #if defined(CYARG_FEATURE_HOSTED_REPL)
 #include "hosted.h"
@@ -282,3 +283,136 @@ bool fileExistsNative(ObjRoutine* routine, int argCount, Value* result) {
     *result = BOOL_VAL(fileExists(path));
     return true;
 }
+
+static bool fileHandleArgument(ObjRoutine* routine, int argCount, int* handle) {
+    Value handleVal = nativeArgument(routine, argCount, 0);
+    if (!is_positive_integer32(handleVal) || !fileHandleOpen(as_positive_integer32(handleVal))) {
+        runtimeError(routine, "Expected an open file handle.");
+        return false;
+    }
+    *handle = as_positive_integer32(handleVal);
+    return true;
+}
+
+// Files are read into and written from the array's own storage, so a dense
+// byte array, or a slice of one, is all that can be accepted.
+static bool byteArrayArgument(ObjRoutine* routine, int argCount, int index, uint8_t** bytes, size_t* length) {
+    Value arrayVal = nativeArgument(routine, argCount, index);
+    if (IS_UNIFORMARRAY(arrayVal)) {
+        PackedValue store = AS_UNIFORMARRAY(arrayVal)->store;
+        ObjConcreteYargTypeArray* type = (ObjConcreteYargTypeArray*) store.storedType;
+        ObjConcreteYargType* element = type->element_type;
+        if (element != NULL && (element->yt == TypeUint8 || element->yt == TypeInt8)
+            && (type->stride == 0 || type->stride == 1)) {
+            *bytes = (uint8_t*) store.storedValue;
+            *length = type->cardinality;
+            return true;
+        }
+    }
+    runtimeError(routine, "Expected a densely packed byte array.");
+    return false;
+}
+
+bool fileOpenNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+
+    Value pathVal = nativeArgument(routine, argCount, 0);
+    Value modeVal = nativeArgument(routine, argCount, 1);
+    if (!IS_STRING(pathVal) || !IS_STRING(modeVal)) {
+        runtimeError(routine, "Expected strings for the file path and mode.");
+        return false;
+    }
+
+    int handle = fileOpen(AS_CSTRING(pathVal), AS_CSTRING(modeVal));
+    *result = handle < 0 ? NIL_VAL : I32_VAL(handle);
+    return true;
+}
+
+bool fileReadNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+
+    int handle;
+    uint8_t* bytes;
+    size_t length;
+    if (!fileHandleArgument(routine, argCount, &handle)
+        || !byteArrayArgument(routine, argCount, 1, &bytes, &length)) {
+        return false;
+    }
+
+    int32_t bytesRead = fileRead(handle, bytes, length);
+    if (bytesRead < 0) {
+        runtimeError(routine, "Could not read from file.");
+        return false;
+    }
+    *result = I32_VAL(bytesRead);
+    return true;
+}
+
+bool fileWriteNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+
+    int handle;
+    uint8_t* bytes;
+    size_t length;
+    if (!fileHandleArgument(routine, argCount, &handle)
+        || !byteArrayArgument(routine, argCount, 1, &bytes, &length)) {
+        return false;
+    }
+
+    int32_t bytesWritten = fileWrite(handle, bytes, length);
+    if (bytesWritten < 0) {
+        runtimeError(routine, "Could not write to file.");
+        return false;
+    }
+    *result = I32_VAL(bytesWritten);
+    return true;
+}
+
+bool fileSeekNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 2) {
+        runtimeError(routine, "Expected 2 arguments but got %d.", argCount);
+        return false;
+    }
+
+    int handle;
+    if (!fileHandleArgument(routine, argCount, &handle)) {
+        return false;
+    }
+    Value positionVal = nativeArgument(routine, argCount, 1);
+    if (!is_positive_integer32(positionVal)) {
+        runtimeError(routine, "Expected a positive integer for the position.");
+        return false;
+    }
+
+    int32_t position = fileSeek(handle, as_positive_integer32(positionVal));
+    if (position < 0) {
+        runtimeError(routine, "Could not seek in file.");
+        return false;
+    }
+    *result = I32_VAL(position);
+    return true;
+}
+
+bool fileCloseNative(ObjRoutine* routine, int argCount, Value* result) {
+    if (argCount != 1) {
+        runtimeError(routine, "Expected 1 argument but got %d.", argCount);
+        return false;
+    }
+
+    int handle;
+    if (!fileHandleArgument(routine, argCount, &handle)) {
+        return false;
+    }
+
+    *result = BOOL_VAL(fileClose(handle));
+    return true;
+}
@@ -17,6 +17,12 @@ bool readFileIntoBufferNative(ObjRoutine* routine, int argCount, Value* result);
 bool fileSizeNative(ObjRoutine* routine, int argCount, Value* result);
 bool fileExistsNative(ObjRoutine* routine, int argCount, Value* result);
 
+bool fileOpenNative(ObjRoutine* routine, int argCount, Value* result);
+bool fileReadNative(ObjRoutine* routine, int argCount, Value* result);
+bool fileWriteNative(ObjRoutine* routine, int argCount, Value* result);
+bool fileSeekNative(ObjRoutine* routine, int argCount, Value* result);
+bool fileCloseNative(ObjRoutine* routine, int argCount, Value* result);
+
 #if defined(CYARG_FEATURE_HOSTED_REPL)
 bool host_argcNative(ObjRoutine* routine, int argCount, Value* result);
 bool host_argnNative(ObjRoutine* routine, int argCount, Value* result);
@@ -10,6 +10,7 @@
 #include "yargtype.h"
 #include "channel.h"
 #include "sync_group.h"
+#include "map.h"
 
 #define ALLOCATE_OBJ(type, objectType) \
     (type*)allocateObject(sizeof(type), objectType)
@@ -116,6 +117,11 @@ void initFunction(ObjFunction* function) {
     function->arity = 0;
     function->upvalueCount = 0;
     function->fName = NULL;
+    function->package = NULL;
+#ifdef CYARG_FEATURE_JIT
+    function->callCount = 0;
+    function->jit = NULL;
+#endif
     initChunk(&function->chunk);
 }
 
@@ -169,7 +175,7 @@ ObjPackedUniformArray* newPackedUniformArray(ObjConcreteYargTypeArray* type) {
     tempRootPush(OBJ_VAL(array));
 
     PackedValue new_array = { .storedType = (ObjConcreteYargType*) type, .storedValue = NULL };
-    new_array.storedValue = reallocate(NULL, 0, arrayElementSize(type) * type->cardinality);
+    new_array.storedValue = reallocate(NULL, 0, arrayStorageSize(type));
 
     for (size_t i = 0; i < type->cardinality; i++) {
         PackedValue el = arrayElement(new_array, i);
@@ -189,6 +195,27 @@ ObjPackedUniformArray* newPackedUniformArrayAt(PackedValue location) {
     return array;
 }
 
+ObjPackedUniformArray* newPackedUniformArrayView(Obj* owner, PackedValue location) {
+
+    ObjPackedUniformArray* array = newPackedUniformArrayAt(location);
+    array->owner = owner;
+
+    return array;
+}
+
+ObjPackedUniformArray* newMappedByteArray(uint8_t* mapped, size_t size) {
+    ObjConcreteYargType* byteType = newYargTypeFromType(TypeUint8);
+    ObjConcreteYargTypeArray* arrayType = (ObjConcreteYargTypeArray*)newYargArrayTypeFromType(OBJ_VAL(byteType), size, 0);
+    tempRootPush(OBJ_VAL(arrayType));
+
+    PackedValue location = { .storedValue = (PackedValueStore*)mapped, .storedType = (ObjConcreteYargType*)arrayType };
+    ObjPackedUniformArray* array = newPackedUniformArrayAt(location);
+    array->mapped = size;
+
+    tempRootPop();
+    return array;
+}
+
 Value defaultArrayValue(ObjConcreteYargType* type) {
 
     ObjConcreteYargTypeArray* arrayType = (ObjConcreteYargTypeArray*)type;
@@ -203,25 +230,28 @@ ObjMap* newMap(ObjConcreteYargTypeMap* type) {
     ObjMap* map = ALLOCATE_OBJ(ObjMap, OBJ_MAP);
     map->type = type;
     initTable(&map->entries);
+    initIntegerTable(&map->integers);
     return map;
 }
 
 ObjPackedPointer* newPointerForHeapCell(PackedValue location) {
 
+    Value targetType = location.storedType ? OBJ_VAL(location.storedType) : NIL_VAL;
+    ObjConcreteYargTypePointer* type = (ObjConcreteYargTypePointer*) newYargPointerType(targetType);
+    tempRootPush(OBJ_VAL(type));
     ObjPackedPointer* ptr = ALLOCATE_OBJ(ObjPackedPointer, OBJ_PACKEDPOINTER);
-    tempRootPush(OBJ_VAL(ptr));
-    ptr->type = (ObjConcreteYargTypePointer*) newYargTypeFromType(TypePointer);
-    ptr->type->target_type = location.storedType;
+    ptr->type = type;
     ptr->destination = location.storedValue;
     tempRootPop();
     return ptr;
 }
 
 ObjPackedPointer* newPointerAtHeapCell(PackedValue location) {
+    Value targetType = location.storedType ? OBJ_VAL(location.storedType) : NIL_VAL;
+    ObjConcreteYargTypePointer* type = (ObjConcreteYargTypePointer*) newYargPointerType(targetType);
+    tempRootPush(OBJ_VAL(type));
     ObjPackedPointer* ptr = ALLOCATE_OBJ(ObjPackedPointer, OBJ_UNOWNED_PACKEDPOINTER);
-    tempRootPush(OBJ_VAL(ptr));
-    ptr->type = (ObjConcreteYargTypePointer*) newYargTypeFromType(TypePointer);
-    ptr->type->target_type = location.storedType;
+    ptr->type = type;
     ptr->destination = location.storedValue;
     tempRootPop();
     return ptr;
@@ -284,6 +314,22 @@ Obj* destinationObject(Value pointer) {
     return NULL;
 }
 
+// The storage of the array or struct a pointer reaches, found without
+// allocating the object destinationObject() would.
+PackedValue pointerTargetStore(Value pointer) {
+    ObjPackedPointer* p = AS_POINTER(pointer);
+    PackedValue dest = { .storedType = p->type->target_type, .storedValue = p->destination };
+    if (dest.storedType == NULL) {
+        Value target = unpackValue(dest);
+        if (IS_UNIFORMARRAY(target)) {
+            return AS_UNIFORMARRAY(target)->store;
+        } else if (IS_STRUCT(target)) {
+            return AS_STRUCT(target)->store;
+        }
+    }
+    return dest;
+}
+
 Value placeObjectAt(Value placedType, Value location) {
     if (is_placeable_type(placedType) && IS_ADDRESS(location)) {
         PackedValue loc;
@@ -349,8 +395,8 @@ PackedValue structField(PackedValue struct_, size_t index) {
     ObjConcreteYargTypeStruct* typeStruct = (ObjConcreteYargTypeStruct*)struct_.storedType;
 
     PackedValue f;
-    f.storedType = typeStruct->field_types[index];
-    f.storedValue = (PackedValueStore*)((uint8_t*)struct_.storedValue + typeStruct->field_indexes[index]);
+    f.storedType = typeStruct->fields[index].type;
+    f.storedValue = (PackedValueStore*)((uint8_t*)struct_.storedValue + typeStruct->fields[index].offset);
     return f;
 }
 
@@ -378,7 +424,7 @@ static uint32_t hashString(const char* key, int length) {
     uint32_t hash = 2166136261u;
     for (int i = 0; i < length; i++) {
         hash ^= (uint8_t)key[i];
-        hash += 16777619;
+        hash *= 16777619;
     }
     return hash;
 }
@@ -405,6 +451,20 @@ ObjString* copyString(const char* chars, int length) {
     return allocateString(heapChars, length, hash);
 }
 
+ObjString* xipString(ObjString* header, const char* chars, int length) {
+    uint32_t hash = hashString(chars, length);
+    ObjString* interned = tableFindString(&vm.strings, chars, length, hash);
+    if (interned != NULL) return interned;
+
+    // Not on the heap, so never traced or swept; marked from the start.
+    header->obj = (Obj){ .type = OBJ_STRING, .isMarked = true, .isPermanent = true, .next = NULL };
+    header->length = length;
+    header->chars = (char*)chars;
+    header->hash = hash;
+    tableSet(&vm.strings, header, NIL_VAL);
+    return header;
+}
+
 ObjString* copyStringWithEscapes(const char* chars, int length)
 {
     char* heapChars = ALLOCATE(char, length + 1);
@@ -553,7 +613,7 @@ void fprintObject(FILE* op, Value value) {
         }
         case OBJ_MAP:
             FPRINTMSG(op, "<map ");
-            FPRINTMSG(op, "(%d) ", AS_MAP(value)->entries.count);
+            FPRINTMSG(op, "(%zu) ", mapCount(AS_MAP(value)));
             printType(op, (ObjConcreteYargType*)(AS_MAP(value)->type));
             FPRINTMSG(op, " >");
             break;
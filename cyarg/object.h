@@ -115,6 +115,7 @@ typedef enum {
 struct Obj {
     ObjType type;
     bool isMarked;
+    bool isPermanent; // a loaded package's constant, outside the heap, see markObject
     struct Obj* next;
 };
 
@@ -131,6 +132,11 @@ typedef struct ObjFunction {
     int upvalueCount;
     Chunk chunk;
     ObjString* fName;
+    struct PackageConstants* package; // the package a loaded function's code is in, kept loaded by it
+#ifdef CYARG_FEATURE_JIT
+    uint32_t callCount;
+    struct JitCode* jit;
+#endif
 } ObjFunction;
 
 typedef bool (*NativeFn)(ObjRoutine* routine, int argCount, Value* result);
@@ -150,6 +156,8 @@ struct ObjString {
 typedef struct ObjInt {
     Obj obj;
     bool isLiteral;
+    bool isTemporary; // a dead stack temporary, marked by OP_INT_TEMPORARY for the arithmetic after it
+    bool isOwned; // the only reference is an int local's slot, see OP_UPDATE_LOCAL_INT
     Int bigInt;
 } ObjInt;
 
@@ -189,6 +197,8 @@ typedef struct {
 typedef struct ObjPackedUniformArray {
     Obj obj;
     PackedValue store;
+    Obj* owner; // the array a view shares storage with, kept alive by the view.
+    size_t mapped; // the length of the file mapping the store is, unmapped with the array, or 0.
 } ObjPackedUniformArray;
 
 typedef struct {
@@ -205,7 +215,8 @@ typedef struct {
 typedef struct {
     Obj obj;
     ObjConcreteYargTypeMap* type;
-    ValueTable entries;
+    ValueTable entries;     // string keys
+    IntegerTable integers;  // fixed width integer keys
 } ObjMap;
 
 #define ALLOCATE_OBJ(type, objectType) \
@@ -232,6 +243,9 @@ ObjMap* newMap(ObjConcreteYargTypeMap* type);
 ObjString* takeString(char* chars, int length);
 ObjString* copyString(const char* chars, int length);
 ObjString* copyStringWithEscapes(const char* chars, int length);
+// Interns chars in place, in storage that outlives the VM such as a package
+// image; header is permanent room for the string if it is not interned already.
+ObjString* xipString(ObjString* header, const char* chars, int length);
 ObjUpvalue* newUpvalue(ValueCell* slot, size_t stackOffset);
 ObjInt* newInt(int64_t value);
 ObjInt* newIntU(uint64_t value);
@@ -247,9 +261,12 @@ ObjPackedPointer* newPointerForHeapCell(PackedValue location);
 ObjPackedPointer* newPointerAtHeapCell(PackedValue location);
 
 Obj* destinationObject(Value pointer);
+PackedValue pointerTargetStore(Value pointer);
 void offsetPointerDestination(ObjPackedPointer* pointer, size_t offset);
 
 ObjPackedUniformArray* newPackedUniformArrayAt(PackedValue location);
+ObjPackedUniformArray* newPackedUniformArrayView(Obj* owner, PackedValue location);
+ObjPackedUniformArray* newMappedByteArray(uint8_t* mapped, size_t size);
 
 Value defaultIntValue();
 Value defaultArrayValue(ObjConcreteYargType* type);
@@ -264,6 +281,13 @@ static inline bool isObjType(Value value, ObjType type) {
     return IS_OBJ(value) && AS_OBJ(value)->type == type;
 }
 
+// A read that can keep the value ends an int local's ownership of it.
+static inline void disownInt(Value value) {
+    if (IS_INT(value)) {
+        AS_INTOBJ(value)->isOwned = false;
+    }
+}
+
 bool isAddressValue(Value value);
 
 bool isArrayPointer(Value value);
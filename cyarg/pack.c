@@ -3,9 +3,17 @@
 
 #include "object.h"
 #include "memory.h"
+#include "compiler.h"
+#include "fs/fs.h"
+#if defined(CYARG_FEATURE_JIT)
+#include "jit.h"
+#endif
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <sysexits.h>
 #include <assert.h>
 
@@ -15,14 +23,29 @@ static void flattenConstants(int funIndex, Chunk const *, FlatFiles *);
 //static void removeCapturedNames(FlatFiles *);
 static void calcStringAndIntOffsets(FlatFiles *);
 static void flattenLines(FlatFiles *);
-static int pack(char const *, FlatFiles *, FILE *);
+static bool translateAot(FlatFiles *);
+static bool fitsPackage(FlatFiles const *);
+static int pack(char const *, FlatFiles *, bool, FILE *);
+static int compressPackage(FILE *, FILE *);
+
+int packScript(char const *sourceFileName, struct ObjFunction const *scriptFn, bool includeLines, bool includeAot, bool compress, char const *path) {
+#if !defined(CYARG_FEATURE_JIT)
+    if (includeAot) return EX_UNAVAILABLE;
+#endif
 
-int packScript(char const *sourceFileName, struct ObjFunction const *scriptFn, bool includeLines, char const *path) {
     FILE *file = fopen(path, "wb");
-    if (file == 0) return EX_DATAERR;
+    if (file == 0) return EX_CANTCREAT;
 
     int r = EX_OK;
 
+    // a compressed package is packed whole first, as the header needs the body's length
+    FILE *image = compress ? tmpfile() : file;
+    if (image == 0) {
+        fclose(file);
+        remove(path);
+        return EX_CANTCREAT;
+    }
+
     FlatFiles f = {0};
     if (includeLines) {
         fileSet(&f.linesFile_, 64, sizeof *f.linesFile_.i_);
@@ -49,14 +72,32 @@ int packScript(char const *sourceFileName, struct ObjFunction const *scriptFn, b
         flattenLines(&f);
     }
 
-    r = pack(sourceFileName, &f, file);
+    if (!fitsPackage(&f)) {
+        r = EX_DATAERR;
+        goto exit;
+    }
+
+    if (includeAot && !translateAot(&f)) {
+        r = EX_SOFTWARE;
+        goto exit;
+    }
+
+    r = pack(sourceFileName, &f, includeAot, image);
     if (r != EX_OK) goto exit;
 
+    if (compress) {
+        r = compressPackage(image, file);
+    }
+
 exit:
+    if (image != file) {
+        fclose(image);
+    }
     fclose(file);
 
     for (int i = 0; i < f.funsFile_.n_; i++) {
         free(f.funsFile_.i_[i].chunk_.constTypesAndOffsets_.i_);
+        free(f.funsFile_.i_[i].chunk_.aotOps_);
     }
     free(f.addressesFile_.i_);
     free(f.funsFile_.i_);
@@ -72,6 +113,57 @@ exit:
     return r;
 }
 
+struct ObjFunction *compileCached(char const *source, char const *cachePath) {
+    uint64_t hash = 14695981039346656037u;
+    hash = (hash ^ (uint8_t) packageVersion) * 1099511628211u;
+    hash = (hash ^ (uint8_t) (packageVersion >> 8)) * 1099511628211u;
+    for (char const *c = source; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t) *c) * 1099511628211u;
+    }
+
+    size_t pathLength = strlen(cachePath) + sizeof "/0123456789abcdef.yb.XXXXXX";
+    char *path = malloc(pathLength);
+    snprintf(path, pathLength, "%s/%016" PRIx64 ".yb", cachePath, hash);
+
+    size_t size = 0;
+    uint8_t *package = mapFile(path, &size);
+    if (package != 0) {
+        // the array owns the mapping, unmapped once the package, or a failed load, lets it go
+        ObjPackedUniformArray *image = newMappedByteArray(package, size);
+        tempRootPush(OBJ_VAL(image));
+        ObjFunction *function = loadPackageFromBuffer(package, size, (Obj *)image);
+        tempRootPop();
+        if (function != 0) {
+            // packed under the name of its cache file, but compile() makes a script
+            function->fName = 0;
+            free(path);
+            return function;
+        }
+    }
+
+    ObjFunction *function = compile(source);
+    if (function != 0) {
+        tempRootPush(OBJ_VAL(function));
+
+        // packed aside and renamed into place, so a concurrent run never maps half a package
+        char *partial = malloc(pathLength);
+        snprintf(partial, pathLength, "%s.XXXXXX", path);
+        mkdir(cachePath, 0777);
+        int fd = mkstemp(partial);
+        if (fd >= 0) {
+            close(fd);
+            if (packScript("script", function, true, false, false, partial) != EX_OK || rename(partial, path) != 0) {
+                remove(partial);
+            }
+        }
+        free(partial);
+
+        tempRootPop();
+    }
+    free(path);
+    return function;
+}
+
 void flattenConstants(int chunkIndex, Chunk const *chunk, FlatFiles *f) {
     int startSubs = f->funsFile_.n_;
     int constCount = chunk->constants.count;
@@ -81,11 +173,12 @@ void flattenConstants(int chunkIndex, Chunk const *chunk, FlatFiles *f) {
 
     fc->code_ = cf->chunk.code;
     fc->codeLength_ = cf->chunk.count;
-    fc->codeOffset_ = f->funsFile_.totalCodeLength_;
     f->funsFile_.totalCodeLength_ += fc->codeLength_;
 
     fc->constTypesAndOffsets_.numConsts_ = 0;
     fc->constTypesAndOffsets_.i_ = 0;
+    fc->aotOps_ = 0;
+    fc->numAotOps_ = 0;
     fileSet(&fc->constTypesAndOffsets_, constCount, sizeof *fc->constTypesAndOffsets_.i_);
     fc->constTypesAndOffsets_.numConsts_ = constCount;
 
@@ -204,29 +297,51 @@ void calcStringAndIntOffsets(FlatFiles *f) {
 }
 
 void flattenLines(FlatFiles *f) {
+    // chunks are written in index order, each line table is already in address order
+    int codeOffset = 0;
     for (int c = 0; c < f->funsFile_.n_; c++) {
         FlatChunk *cf = &f->funsFile_.i_[c].chunk_;
         Chunk const *chunk = &f->funsFile_.i_[c].f_->chunk;
 
-        if (chunk->numLines > 0) {
-            int lastLine = chunk->lines[chunk->numLines - 1].line;
-            int flattenedLines = f->linesFile_.n_;
-            
-            if (lastLine > flattenedLines) {
-                fileSet(&f->linesFile_, lastLine, sizeof *f->linesFile_.i_);
-                f->linesFile_.n_ = lastLine;
-                memset(&f->linesFile_.i_[flattenedLines], 0xff, sizeof (uint32_t) * (lastLine - flattenedLines));
-            }
-            
-            for (int i = 0; i < chunk->numLines; i++) {
-                int a = chunk->lines[i].address;
-                int l = chunk->lines[i].line;
-                assert(l <= f->linesFile_.extent_);
-                if (l > f->linesFile_.n_) f->linesFile_.n_ = l;
-                f->linesFile_.i_[l - 1] = a + cf->codeOffset_;
-            }
+        fileExtend(&f->linesFile_, chunk->numLines, sizeof *f->linesFile_.i_);
+        for (int i = 0; i < chunk->numLines; i++) {
+            // a line with no code after it would be taken for the next chunk's first
+            if (chunk->lines[i].address >= cf->codeLength_) break;
+            f->linesFile_.i_[f->linesFile_.n_++] = (LineItem){
+                .offset_ = chunk->lines[i].address + codeOffset,
+                .line_ = chunk->lines[i].line
+            };
         }
+        codeOffset += cf->codeLength_;
+    }
+}
+
+bool fitsPackage(FlatFiles const *f) {
+    for (int c = 0; c < f->funsFile_.n_; c++) {
+        struct ConstTypesAndOffsets const *ctao = &f->funsFile_.i_[c].chunk_.constTypesAndOffsets_;
+        for (int k = 0; k < ctao->numConsts_; k++) {
+            ConstItem const *ci = &ctao->i_[k];
+            uint32_t indexOrOffset = ci->type_ == PACK_CONST_TYPE_S || ci->type_ == PACK_CONST_TYPE_I ? ci->offset_ : ci->index_;
+            if (indexOrOffset > PACKAGE_MAX_OFFSET) return false;
+        }
+    }
+    for (int i = 0; i < f->linesFile_.n_; i++) {
+        if (f->linesFile_.i_[i].offset_ > PACKAGE_MAX_OFFSET || f->linesFile_.i_[i].line_ > PACKAGE_MAX_OFFSET) return false;
+    }
+    return true;
+}
+
+bool translateAot(FlatFiles *f) {
+#if defined(CYARG_FEATURE_JIT)
+    for (int c = 0; c < f->funsFile_.n_; c++) {
+        FlatChunk *fc = &f->funsFile_.i_[c].chunk_;
+        fc->numAotOps_ = jitPack(f->funsFile_.i_[c].f_, &fc->aotOps_);
+        if (fc->aotOps_ == 0) return false;
     }
+    return true;
+#else
+    return false;
+#endif
 }
 
 #if defined(DEBUG_PACK)
@@ -240,12 +355,23 @@ size_t fwrite__(const void *__ptr, size_t __size, size_t __nitems, FILE *__strea
 #define fwrite__(P__, S__, N__, F__) fwrite(P__, S__, N__, F__)
 #endif // !DEBUGGING_PACK
 
-int pack(char const *sourceFileName, FlatFiles *f, FILE *file) {
+// the script is named for its source file, the chunks that follow for their functions
+static char const *chunkName(char const *sourceFileName, FlatFiles *f, int i, int *len) {
+    if (i == 0) {
+        *len = (int) strlen(sourceFileName);
+        return sourceFileName;
+    }
+    *len = f->funsFile_.i_[i].f_->fName->length;
+    return f->funsFile_.i_[i].f_->fName->chars;
+}
+
+int pack(char const *sourceFileName, FlatFiles *f, bool includeAot, FILE *file) {
 
     PackageFileHeader h;
 
     memcpy(&h.magic_, packageMagic, PACKAGE_MAGIC_LEN);
     h.version_ = packageVersion;
+    h.flags_ = 0;
     h.numChunks_ = f->funsFile_.n_;
     h.numStrings_ = f->stringsFile_.n_;
     h.numInts_ = f->intsFile_.n_;
@@ -257,7 +383,7 @@ int pack(char const *sourceFileName, FlatFiles *f, FILE *file) {
     h.bodyLength_ += h.numDoubles_ * sizeof (double);
     h.bodyLength_ += h.numAddresses_ * sizeof (int64_t);
 
-    h.bodyLength_ += 8 * f->funsFile_.n_;
+    h.bodyLength_ += 12 * f->funsFile_.n_;
     for (int i = 0; i < f->funsFile_.n_; i++) {
         h.bodyLength_ += 4 * f->funsFile_.i_[i].chunk_.constTypesAndOffsets_.numConsts_;
     }
@@ -265,9 +391,21 @@ int pack(char const *sourceFileName, FlatFiles *f, FILE *file) {
     assert(h.bodyLength_ % 4 == 0);
     h.bodyLength_ += f->stringsFile_.totalStringLength_;
     h.bodyLength_ += f->funsFile_.totalCodeLength_;
-    h.bodyLength_ += 3 * h.numLines_;
+    h.bodyLength_ += 6 * h.numLines_;
     if (h.numLines_ > 0) {
-        h.bodyLength_ += 16 * h.numChunks_;
+        for (int i = 0; i < f->funsFile_.n_; i++) {
+            int len;
+            chunkName(sourceFileName, f, i, &len);
+            h.bodyLength_ += len + 1;
+        }
+    }
+    uint32_t aotPadding = 0;
+    if (includeAot) {
+        aotPadding = (4 - h.bodyLength_ % 4) % 4;
+        h.bodyLength_ += aotPadding + 4;
+        for (int i = 0; i < f->funsFile_.n_; i++) {
+            h.bodyLength_ += 4 + PACKAGE_AOT_OP_SIZE * f->funsFile_.i_[i].chunk_.numAotOps_;
+        }
     }
 
     size_t written = fwrite__(&h, sizeof h, 1, file);
@@ -298,9 +436,10 @@ int pack(char const *sourceFileName, FlatFiles *f, FILE *file) {
             numUpvalues = fn->upvalueCount;
         }
 
-        written = fwrite__(&fc->constTypesAndOffsets_.numConsts_, sizeof (uint16_t), 1, file);
+        uint32_t codeLength = fc->codeLength_;
+        written = fwrite__(&fc->constTypesAndOffsets_.numConsts_, sizeof (uint32_t), 1, file);
         if (written != 1) return EX_SOFTWARE;
-        written = fwrite__(&fc->codeLength_, sizeof (uint16_t), 1, file);
+        written = fwrite__(&codeLength, sizeof (uint32_t), 1, file);
         if (written != 1) return EX_SOFTWARE;
         written = fwrite__(&arity, sizeof (uint16_t), 1, file);
         if (written != 1) return EX_SOFTWARE;
@@ -354,40 +493,149 @@ int pack(char const *sourceFileName, FlatFiles *f, FILE *file) {
 
     DP(lines__ = offset__);
     for (int i = 0; i < f->linesFile_.n_; i++) {
-        uint32_t offset = f->linesFile_.i_[i];
-        written = fwrite__(&offset, sizeof (char), 3, file);
+        LineItem *item = &f->linesFile_.i_[i];
+        written = fwrite__(&item->offset_, sizeof (char), 3, file);
+        if (written != 3) return EX_SOFTWARE;
+        written = fwrite__(&item->line_, sizeof (char), 3, file);
         if (written != 3) return EX_SOFTWARE;
     }
 
     DP(names__ = offset__);
     if (f->linesFile_.n_ > 0) {
         for (int i = 0; i < f->funsFile_.n_; i++) {
-            char const *name;
             int len;
-            if (i == 0) {
-                name = sourceFileName;
-                len = (int) strlen(sourceFileName);
-            } else {
-                name = f->funsFile_.i_[i].f_->fName->chars;
-                len = f->funsFile_.i_[i].f_->fName->length;
-            }
-            if (len > 15) len = 15;
-            written = fwrite__(name, sizeof (char), len, file);
-            if (written != len) return EX_SOFTWARE;
-            for (; len < 16; len++) {
-                char nullChar = 0;
-                written = fwrite__(&nullChar, sizeof (char), 1, file);
-                if (written != 1) return EX_SOFTWARE;
-            }
+            char const *name = chunkName(sourceFileName, f, i, &len);
+            written = fwrite__(name, sizeof (char), len + 1, file);
+            if (written != len + 1) return EX_SOFTWARE;
             DP(printf("%s\n", name));
         }
     }
+    DP(aot__ = offset__);
+    if (includeAot) {
+        uint32_t zero = 0;
+        written = fwrite__(&zero, sizeof (char), aotPadding, file);
+        if (written != aotPadding) return EX_SOFTWARE;
+        uint32_t magic = PACKAGE_AOT_MAGIC;
+        written = fwrite__(&magic, sizeof (uint32_t), 1, file);
+        if (written != 1) return EX_SOFTWARE;
+        for (int i = 0; i < f->funsFile_.n_; i++) {
+            FlatChunk *fc = &f->funsFile_.i_[i].chunk_;
+            uint32_t numOps = fc->numAotOps_;
+            written = fwrite__(&numOps, sizeof (uint32_t), 1, file);
+            if (written != 1) return EX_SOFTWARE;
+            written = fwrite__(fc->aotOps_, PACKAGE_AOT_OP_SIZE, numOps, file);
+            if (written != numOps) return EX_SOFTWARE;
+        }
+    }
+
     DP(end__ = offset__);
-    DP(printf("chunks__:%u\nints__:%u\nstrings__:%u\ncode__:%u\nlines__:%u\nnames__:%u\nend__:%u\n", chunks__, ints__, strings__, code__, lines__, names__, end__));
+    DP(printf("chunks__:%u\nints__:%u\nstrings__:%u\ncode__:%u\nlines__:%u\nnames__:%u\naot__:%u\nend__:%u\n", chunks__, ints__, strings__, code__, lines__, names__, aot__, end__));
 
     return EX_OK;
 }
 
+#define MATCH_HASH_BITS 12
+
+static uint32_t matchHash(uint8_t const *at) {
+    uint32_t prefix = at[0] | at[1] << 8 | at[2] << 16;
+    return (prefix * 2654435761u) >> (32 - MATCH_HASH_BITS);
+}
+
+// lzss, as described in pack_format.h, finding the longest match in the window
+// by chaining earlier positions whose first PACKAGE_MIN_MATCH bytes hash alike.
+static uint32_t compressBody(uint8_t const *in, uint32_t length, uint8_t *out) {
+    int32_t *head = malloc((1 << MATCH_HASH_BITS) * sizeof *head);
+    int32_t *chain = malloc(length * sizeof *chain + 1);
+    for (int i = 0; i < 1 << MATCH_HASH_BITS; i++) {
+        head[i] = -1;
+    }
+
+    uint32_t o = 0;
+    uint32_t flagsAt = 0;
+    int items = 8;
+    uint32_t i = 0;
+    while (i < length) {
+        if (items == 8) {
+            flagsAt = o++;
+            out[flagsAt] = 0;
+            items = 0;
+        }
+
+        uint32_t bestLength = 0;
+        uint32_t bestDistance = 0;
+        if (length - i >= PACKAGE_MIN_MATCH) {
+            uint32_t maxLength = length - i < PACKAGE_MAX_MATCH ? length - i : PACKAGE_MAX_MATCH;
+            for (int32_t c = head[matchHash(&in[i])]; c >= 0 && i - c <= PACKAGE_WINDOW; c = chain[c]) {
+                uint32_t n = 0;
+                while (n < maxLength && in[c + n] == in[i + n]) n++;
+                if (n > bestLength) {
+                    bestLength = n;
+                    bestDistance = i - c;
+                    if (n == maxLength) break;
+                }
+            }
+        }
+
+        if (bestLength >= PACKAGE_MIN_MATCH) {
+            uint16_t match = (uint16_t)((bestDistance - 1) | (bestLength - PACKAGE_MIN_MATCH) << PACKAGE_WINDOW_BITS);
+            out[o++] = match & 0xff;
+            out[o++] = match >> 8;
+        } else {
+            out[flagsAt] |= 1 << items;
+            out[o++] = in[i];
+            bestLength = 1;
+        }
+        items++;
+
+        for (uint32_t end = i + bestLength; i < end; i++) {
+            if (length - i >= PACKAGE_MIN_MATCH) {
+                uint32_t hash = matchHash(&in[i]);
+                chain[i] = head[hash];
+                head[hash] = (int32_t)i;
+            }
+        }
+    }
+
+    free(chain);
+    free(head);
+    return o;
+}
+
+int compressPackage(FILE *image, FILE *file) {
+    long size = ftell(image);
+    if (size < (long) sizeof (PackageFileHeader)) return EX_SOFTWARE;
+
+    uint32_t bodyLength = (uint32_t)(size - sizeof (PackageFileHeader));
+    uint8_t *package = malloc(size);
+    // at worst every byte is a literal, costing another flag byte every eight
+    uint8_t *stream = malloc(bodyLength + bodyLength / 8 + 1);
+
+    int r = EX_OK;
+    rewind(image);
+    if (fread(package, size, 1, image) != 1) {
+        r = EX_SOFTWARE;
+        goto exit;
+    }
+
+    PackageFileHeader *h = (PackageFileHeader *) package;
+    assert(h->bodyLength_ == bodyLength);
+    h->flags_ |= PACKAGE_FLAG_COMPRESSED;
+
+    uint32_t streamLength = compressBody(package + sizeof *h, bodyLength, stream);
+    DP(printf("body:%u stream:%u\n", bodyLength, streamLength));
+
+    if (fwrite(h, sizeof *h, 1, file) != 1
+        || fwrite(&streamLength, sizeof streamLength, 1, file) != 1
+        || fwrite(stream, 1, streamLength, file) != streamLength) {
+        r = EX_SOFTWARE;
+    }
+
+exit:
+    free(stream);
+    free(package);
+    return r;
+}
+
 void fileSet(void *f, int n, size_t i) {
 
     LinesFile *file = (LinesFile *) f;
@@ -5,9 +5,21 @@
 #include <stdint.h>
 #include <stddef.h>
 
+struct Obj;
 struct ObjFunction;
+struct PackageConstants;
 
-int packScript(char const *sourceFileName, struct ObjFunction const *scriptFn, bool includeLines, char const *path);
-struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize);
+// receives a package as it is unpacked, in order, a window at a time
+typedef bool (*PackageSink)(void* context, uint8_t const* bytes, size_t length);
+
+int packScript(char const *sourceFileName, struct ObjFunction const *scriptFn, bool includeLines, bool includeAot, bool compress, char const *path);
+struct ObjFunction *compileCached(char const *source, char const *cachePath);
+int unpackPackage(uint8_t const* buffer, size_t bufferSize, PackageSink sink, void* context);
+// image is the object holding buffer, kept alive by the package; NULL if buffer is never freed.
+struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize, struct Obj* image);
+void markPackage(struct PackageConstants* package);
+void markPackageOf(struct Obj* constant);
+void sweepPackages(void);
+void freePackageConstants(void);
 
 #endif
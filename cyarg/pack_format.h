@@ -12,11 +12,21 @@
 #endif
 
 #define PACKAGE_MAGIC_LEN 6
+#define PACKAGE_AOT_MAGIC 0x31544f41 // template ids as of JIT_PACKED_TEMPLATES in jit.h
+#define PACKAGE_AOT_OP_SIZE 16
+#define PACKAGE_MAX_OFFSET 0xffffff // constants and lines are addressed in 3 bytes
+
+#define PACKAGE_FLAG_COMPRESSED 0x1
+#define PACKAGE_WINDOW_BITS 10
+#define PACKAGE_WINDOW (1 << PACKAGE_WINDOW_BITS)
+#define PACKAGE_MIN_MATCH 3
+#define PACKAGE_MAX_MATCH (PACKAGE_MIN_MATCH + (1 << (16 - PACKAGE_WINDOW_BITS)) - 1)
 
 typedef struct ObjString ObjString;
 typedef struct ObjInt ObjInt;
 typedef struct ObjFunction ObjFunction;
 typedef struct Chunk Chunk;
+typedef struct JitPackedOp JitPackedOp;
 
 extern int8_t const packageMagic[PACKAGE_MAGIC_LEN];
 extern int16_t const packageVersion;
@@ -26,40 +36,55 @@ extern int16_t const packageVersion;
 //
 // =-= Header =-=
 // 0    magic(6) - 79 0a 72 67 00 42
-// 6    version(2) - 26, 01 - year, issue (update for any changes to byte-code, number format, file format)
-// 8  M chunks(2) -- 0..65535 (0: just global)
-// 10 N strings(2) -- max 64k strings
-// 12 D doubles(2) -- max 64k floats
-// 14 Q ints(2) -- max 64k ints
-// 16 L lines(2) -- min zero, max 64k lines - debug/error reporting
-// 18 A addresses(2) -- max 64k addresses
-// 20 B body length(4)
+// 6    version(2) - 26, 05 - year, issue (update for any changes to byte-code, number format, file format)
+// 8  B body length(4)
+// 12   flags(4) - 1: compressed body
+// 16 M chunks(4) -- (1: just global)
+// 20 N strings(4)
+// 24 D doubles(4)
+// 28 Q ints(4)
+// 32 L lines(4) -- min zero - debug/error reporting, one per change of line
+// 36 A addresses(4)
 // =-= Body =-=
 // x8   double D*8
 // x8   addresses A*8
 // per chunk -- m == M-1
-// x8 K0    num consts in chunk0 2
-// x1       code length for chunk0 2
-// x1       0 2
-// x1       0 2
-// x8       consts -- K0*4 - type(1):index/offset(3)
-// x8 K1    num consts in chunk0 2
-// x1       code length for chunk0 2
-// x1       arity 2
-// x1       num upvalues 2
+// x8 K0    num consts in chunk0 4 -- up to 64k, the byte-code reaches past 256 with OP_WIDE
+// x4       code length for chunk0 4
+// x4       0 2
+// x2       0 2
+// x4       consts -- K0*4 - type(1):index/offset(3)
+// x4 K1    num consts in chunk1 4
+// x4       code length for chunk1 4
+// x4       arity 2
+// x2       num upvalues 2
 // x4       consts -- K1*4
 // …
-// x4 Km    num consts in chunk0 2
-// x1       code length for chunk0 2
-// x1       arity 2
-// x1       num upvalues 2
+// x4 Km    num consts in chunkm 4
+// x4       code length for chunkm 4
+// x4       arity 2
+// x2       num upvalues 2
 // x4       consts -- Km*4
 // x4   ints *1 -- these could be shrunk by two or four bytes each, but would not then be xip
 // x1   strings *1
 // x1   function arities(M-1)*1
 // x1   code *1
-// x1   code offsets for lines L*3
-// x1   function names (M)x16 -- included if (L > 0) debug/error reporting, truncated if over 15 chars
+// x1   lines L*6 - code offset(3):line(3), in code order
+// x1   function names (M)*1 -- included if (L > 0) debug/error reporting, zero terminated
+// x4   aot section -- optional, present if the body extends past the names
+// x4       magic(4) - 41 4f 54 31 "AOT1"
+// per chunk
+// x4 P0    num ops in chunk0 4
+// x4       ops -- P0*16 - template(1):0(3):code offset(4):next(4):operand(4)
+// …
+//
+// =-= Compressed body =-= -- flags & 1, body length stays that of the body once unpacked
+// x8   stream length(4)
+// x4   stream -- lzss, each flag byte (lsb first) tells whether the next eight items are
+//          a literal byte (1) or a match (0) of two bytes, lsb first, holding distance-1
+//          in the low PACKAGE_WINDOW_BITS bits and length-PACKAGE_MIN_MATCH above them.
+//          Matches reach back at most PACKAGE_WINDOW bytes, so a ring of that size is
+//          all the unpacker needs, whichever sink the unpacked bytes go to.
 
 #if defined(DEBUG_PACK)
 uint32_t chunks__ = 0;
@@ -68,25 +93,32 @@ uint32_t strings__ = 0;
 uint32_t code__ = 0;
 uint32_t lines__ = 0;
 uint32_t names__ = 0;
+uint32_t aot__ = 0;
 uint32_t end__ = 0;
 #endif
 
 typedef struct {
     uint8_t magic_[PACKAGE_MAGIC_LEN];  // 79 0a 72 67 ff 42 "y\x0arg\xffB"
     uint16_t version_;                  // update for any changes to byte-code, number format or package format)
-    uint16_t numChunks_;
-    uint16_t numStrings_;
-    uint16_t numDoubles_;
-    uint16_t numInts_;
-    uint16_t numLines_;
-    uint16_t numAddresses_;
     uint32_t bodyLength_;
+    uint32_t flags_;
+    uint32_t numChunks_;
+    uint32_t numStrings_;
+    uint32_t numDoubles_;
+    uint32_t numInts_;
+    uint32_t numLines_;
+    uint32_t numAddresses_;
 } PackageFileHeader;
 
+typedef struct {
+    uint32_t offset_;
+    uint32_t line_;
+} LineItem;
+
 typedef struct {
     uint32_t n_;
     uint32_t extent_;
-    uint32_t *i_;
+    LineItem *i_;
 } LinesFile;
 
 enum { PACK_CONST_TYPE_S, PACK_CONST_TYPE_I, PACK_CONST_TYPE_D, PACK_CONST_TYPE_F, PACK_CONST_TYPE_A};
@@ -102,12 +134,13 @@ typedef struct {
 typedef struct {
     uint8_t *code_;
     int codeLength_;
-    int codeOffset_;
     struct ConstTypesAndOffsets {
         uint32_t numConsts_;
         uint32_t extent_;
         ConstItem *i_;
     } constTypesAndOffsets_;
+    JitPackedOp *aotOps_;
+    int numAotOps_;
 } FlatChunk;
 
 typedef struct {
@@ -3,24 +3,304 @@
 
 #include "object.h"
 #include "memory.h"
+#include "yargtype.h"
+#include "vm.h"
+#if defined(CYARG_FEATURE_JIT)
+#include "jit.h"
+#endif
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
-enum { PACKAGE_OK = 0, PACKAGE_DATAERR = 65, PACKAGE_PROTOCOL = 71, PACKAGE_SOFTWARE = 70 };
+enum { PACKAGE_OK = 0, PACKAGE_DATAERR = 65, PACKAGE_PROTOCOL = 71, PACKAGE_SOFTWARE = 70, PACKAGE_IOERR = 74 };
 
 int8_t const packageMagic[PACKAGE_MAGIC_LEN] = {0x79, 0x0a, 0x72, 0x67, 0xff, 0x42};
-int16_t const packageVersion = 0x2602;
+int16_t const packageVersion = 0x2605;
+
+typedef uint8_t Uint24[3];
+typedef struct {
+    uint32_t numConsts_;
+    uint32_t codeLength_;
+    uint16_t arity_;
+    uint16_t numUpvalues_;
+    struct {
+        uint8_t type_;
+        Uint24 constOffset_;
+    } typedIndexs[];
+} PackedChunk;
+
+// A package's string and int constants, kept off the heap: the GC neither
+// counts, traces nor sweeps them. Strings keep their characters in the package
+// image itself. Marking a constant, or a function loaded from the package,
+// marks the package and through it the image; a package left unmarked is
+// released whole by sweepPackages.
+typedef struct PackageConstants {
+    struct PackageConstants* next;
+    Obj* image;         // holds the buffer the package was loaded from, NULL if that's never freed
+    uint8_t* unpacked;  // a compressed package's body, unpacked and freed with it
+    bool isMarked;
+    bool isLoading;     // nothing references the package until its functions are bound
+    size_t used;
+    size_t capacity;
+    _Alignas(8) uint8_t objects[];
+} PackageConstants;
+
+// each permanent object is preceded by the package it belongs to
+typedef struct {
+    _Alignas(8) PackageConstants* package;
+} PermanentHeader;
+
+static PackageConstants* packageConstants = NULL;
+
+static size_t permanentSize(size_t size) {
+    return (sizeof (PermanentHeader) + size + 7) & ~(size_t)7;
+}
+
+static void* permanentObject(PackageConstants* constants, size_t size) {
+    assert(constants->used + permanentSize(size) <= constants->capacity);
+    PermanentHeader* header = (PermanentHeader*)&constants->objects[constants->used];
+    header->package = constants;
+    constants->used += permanentSize(size);
+    return header + 1;
+}
+
+static size_t permanentIntSize(Int const* thisInt) {
+    return sizeof (ObjInt) + sizeof (uint16_t) * thisInt->m_;
+}
+
+static ObjInt* permanentInt(PackageConstants* constants, Int const* thisInt) {
+    ObjInt* obj = permanentObject(constants, permanentIntSize(thisInt));
+    obj->obj = (Obj){ .type = OBJ_INT, .isMarked = true, .isPermanent = true, .next = NULL };
+    obj->isLiteral = true;
+    obj->isTemporary = false;
+    obj->isOwned = false;
+    memcpy(&obj->bigInt, thisInt, sizeof (Int) + sizeof (uint16_t) * thisInt->m_);
+    return obj;
+}
+
+static ObjString* permanentString(PackageConstants* constants, char const* chars) {
+    assert(constants->used + permanentSize(sizeof (ObjString)) <= constants->capacity);
+    ObjString* header = (ObjString*)((PermanentHeader*)&constants->objects[constants->used] + 1);
+    ObjString* string = xipString(header, chars, (int)strlen(chars));
+    if (string == header) {
+        permanentObject(constants, sizeof (ObjString));
+    }
+    return string;
+}
+
+static ObjInt* findPermanentInt(ObjInt* const* ints, uint32_t const* offsets, int numInts, uint32_t offset) {
+    int lo = 0;
+    int hi = numInts - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (offsets[mid] == offset) {
+            return ints[mid];
+        } else if (offsets[mid] < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    assert(!"int constant offset");
+    return NULL;
+}
+
+// The chunk whose code holds offset, the code of each following the last.
+static int chunkAt(ObjFunction* const* functions, int numChunks, uint8_t const* startOfCode, size_t offset) {
+    int lo = 0;
+    int hi = numChunks - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if ((size_t)(functions[mid]->chunk.code - startOfCode) <= offset) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+typedef struct {
+    PackageSink sink;
+    void* context;
+    uint8_t* window;
+    size_t unpacked;
+} Unpacker;
+
+// the window doubles as the buffer handed to the sink each time it fills
+static bool unpackByte(Unpacker* unpacker, uint8_t byte) {
+    unpacker->window[unpacker->unpacked++ % PACKAGE_WINDOW] = byte;
+    if (unpacker->unpacked % PACKAGE_WINDOW == 0) {
+        return unpacker->sink(unpacker->context, unpacker->window, PACKAGE_WINDOW);
+    }
+    return true;
+}
+
+int unpackPackage(uint8_t const* buffer, size_t bufferSize, PackageSink sink, void* context) {
+    PackageFileHeader const* h = (PackageFileHeader const*)buffer;
+
+    if (bufferSize < sizeof *h) return PACKAGE_DATAERR;
+    if (memcmp(h->magic_, packageMagic, PACKAGE_MAGIC_LEN) != 0) return PACKAGE_PROTOCOL;
+    if (h->version_ != packageVersion) return PACKAGE_DATAERR;
+
+    if (!(h->flags_ & PACKAGE_FLAG_COMPRESSED)) {
+        if (h->bodyLength_ > bufferSize - sizeof *h) return PACKAGE_DATAERR;
+        return sink(context, buffer, sizeof *h + h->bodyLength_) ? PACKAGE_OK : PACKAGE_IOERR;
+    }
+
+    uint32_t streamLength;
+    if (bufferSize - sizeof *h < sizeof streamLength) return PACKAGE_DATAERR;
+    memcpy(&streamLength, buffer + sizeof *h, sizeof streamLength);
+    if (streamLength > bufferSize - sizeof *h - sizeof streamLength) return PACKAGE_DATAERR;
+
+    PackageFileHeader unpackedHeader = *h;
+    unpackedHeader.flags_ &= ~PACKAGE_FLAG_COMPRESSED;
+    if (!sink(context, (uint8_t const*)&unpackedHeader, sizeof unpackedHeader)) return PACKAGE_IOERR;
+
+    uint8_t const* in = buffer + sizeof *h + sizeof streamLength;
+    uint8_t const* const end = in + streamLength;
+    size_t const bodyLength = h->bodyLength_;
 
-struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize) {
+    int r = PACKAGE_OK;
+    Unpacker unpacker = { .sink = sink, .context = context, .window = malloc(PACKAGE_WINDOW), .unpacked = 0 };
+
+    while (unpacker.unpacked < bodyLength) {
+        if (in == end) {
+            r = PACKAGE_DATAERR;
+            goto exit;
+        }
+        uint8_t flags = *in++;
+        for (int item = 0; item < 8 && unpacker.unpacked < bodyLength; item++) {
+            if (flags & (1 << item)) {
+                if (in == end) {
+                    r = PACKAGE_DATAERR;
+                    goto exit;
+                }
+                if (!unpackByte(&unpacker, *in++)) {
+                    r = PACKAGE_IOERR;
+                    goto exit;
+                }
+            } else {
+                if (end - in < 2) {
+                    r = PACKAGE_DATAERR;
+                    goto exit;
+                }
+                uint16_t match = (uint16_t)(in[0] | in[1] << 8);
+                in += 2;
+                size_t distance = (match & (PACKAGE_WINDOW - 1)) + 1;
+                size_t length = (match >> PACKAGE_WINDOW_BITS) + PACKAGE_MIN_MATCH;
+                if (distance > unpacker.unpacked || length > bodyLength - unpacker.unpacked) {
+                    r = PACKAGE_DATAERR;
+                    goto exit;
+                }
+                for (size_t n = 0; n < length; n++) {
+                    uint8_t byte = unpacker.window[(unpacker.unpacked - distance) % PACKAGE_WINDOW];
+                    if (!unpackByte(&unpacker, byte)) {
+                        r = PACKAGE_IOERR;
+                        goto exit;
+                    }
+                }
+            }
+        }
+    }
+
+    size_t partial = unpacker.unpacked % PACKAGE_WINDOW;
+    if (partial > 0 && !sink(context, unpacker.window, partial)) {
+        r = PACKAGE_IOERR;
+    }
+
+exit:
+    free(unpacker.window);
+    return r;
+}
+
+typedef struct {
+    uint8_t* at;
+    uint8_t* end;
+} ImageSink;
+
+static bool appendToImage(void* context, uint8_t const* bytes, size_t length) {
+    ImageSink* image = context;
+    if (length > (size_t)(image->end - image->at)) return false;
+    memcpy(image->at, bytes, length);
+    image->at += length;
+    return true;
+}
+
+void markPackage(PackageConstants* package) {
+    if (package == NULL || package->isMarked) return;
+    package->isMarked = true;
+    markObject(package->image);
+}
+
+void markPackageOf(Obj* constant) {
+    markPackage(((PermanentHeader*)constant - 1)->package);
+}
+
+static void freePackage(PackageConstants* package) {
+    free(package->unpacked);
+    free(package);
+}
+
+void sweepPackages(void) {
+    PackageConstants** link = &packageConstants;
+    while (*link != NULL) {
+        PackageConstants* package = *link;
+        if (package->isMarked || package->isLoading) {
+            package->isMarked = false;
+            link = &package->next;
+            continue;
+        }
+
+        // nothing reaches its constants, so the strings it interned go too
+        for (size_t used = 0; used < package->used;) {
+            Obj* object = (Obj*)((PermanentHeader*)&package->objects[used] + 1);
+            if (object->type == OBJ_STRING) {
+                tableDelete(&vm.strings, (ObjString*)object);
+                used += permanentSize(sizeof (ObjString));
+            } else {
+                used += permanentSize(permanentIntSize(&((ObjInt*)object)->bigInt));
+            }
+        }
+        *link = package->next;
+        freePackage(package);
+    }
+}
+
+void freePackageConstants(void) {
+    while (packageConstants != NULL) {
+        PackageConstants* next = packageConstants->next;
+        freePackage(packageConstants);
+        packageConstants = next;
+    }
+}
+
+static ObjFunction* loadPackage(uint8_t* buffer, size_t bufferSize, Obj* image, uint8_t* unpacked);
+
+struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize, Obj* image) {
+    return loadPackage(buffer, bufferSize, image, NULL);
+}
+
+// unpacked is the package's own copy of a compressed body, buffer, which it frees.
+static ObjFunction* loadPackage(uint8_t* buffer, size_t bufferSize, Obj* image, uint8_t* unpacked) {
     int r = PACKAGE_OK;
 
     ObjFunction **functions = 0;
+    PackedChunk const **chunks = 0;
+    ObjInt **ints = 0;
+    uint32_t *intOffsets = 0;
+    ObjPackedUniformArray *holder = 0;
+    PackageConstants *constants = 0;
 
     PackageFileHeader* h = (PackageFileHeader*)buffer;
-    assert(sizeof *h == 24);
+    assert(sizeof *h == 40);
 
+    if (bufferSize < sizeof *h) {
+        r = PACKAGE_DATAERR;
+        goto exit;
+    }
     if (memcmp(h->magic_, packageMagic, PACKAGE_MAGIC_LEN) != 0) {
         r = PACKAGE_PROTOCOL;
     }
@@ -29,7 +309,26 @@ struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize) {
         goto exit;
     }
 
-    assert(h->bodyLength_ == bufferSize - sizeof *h);
+    if (h->flags_ & PACKAGE_FLAG_COMPRESSED) {
+        // unpacked once, into memory the package keeps, as its constants reference
+        // its strings in place
+        size_t imageSize = sizeof *h + h->bodyLength_;
+        uint8_t* body = malloc(imageSize);
+
+        ImageSink sink = { .at = body, .end = body + imageSize };
+        r = unpackPackage(buffer, bufferSize, appendToImage, &sink);
+        if (r != PACKAGE_OK) {
+            free(body);
+            goto exit;
+        }
+        return loadPackage(body, imageSize, NULL, body);
+    }
+
+    // an image placed in flash may sit in a larger region than the package needs
+    if (h->bodyLength_ > bufferSize - sizeof *h) {
+        r = PACKAGE_DATAERR;
+        goto exit;
+    }
 
     uint8_t* const body = (uint8_t*)buffer + sizeof *h;
     assert((long)body % 8 == 0);
@@ -38,33 +337,50 @@ struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize) {
     int64_t const *addresses = (int64_t *)(body + h->numDoubles_ * sizeof (double));
     uint8_t const *next =  (uint8_t *)addresses + h->numAddresses_ * sizeof (int64_t);
 
-    typedef uint8_t Uint24[3];
-    typedef struct {
-        uint16_t numConsts_;
-        uint16_t codeLength_;
-        uint16_t arity_;
-        uint16_t numUpvalues_;
-        struct {
-            uint8_t type_;
-            Uint24 constOffset_;
-        } typedIndexs[];
-    } PackedChunk;
-    PackedChunk const *chunks[256];
+    chunks = malloc(h->numChunks_ * sizeof (PackedChunk const *) + 1);
 
     DP(chunks__ = (uint32_t)(next - body));
     for (int i = 0; i < h->numChunks_; i++) {
         chunks[i] = (PackedChunk const *)next;
-        next += 8 + 4 * chunks[i]->numConsts_;
+        next += sizeof (PackedChunk) + 4 * chunks[i]->numConsts_;
     }
     uint8_t const *intFile = next;
 
     DP(ints__ = (uint32_t)(next - body));
+    size_t intBytes = 0;
     for (int i = 0; i < h->numInts_; i++) {
         Int const *thisInt = (Int const *)next;
+        intBytes += permanentSize(permanentIntSize(thisInt));
         next += sizeof (Int) + sizeof (uint16_t) * thisInt->m_;
     }
     uint8_t const *stringFile = next;
 
+    // room for every int and, at most, every string and function name
+    size_t capacity = intBytes + permanentSize(sizeof (ObjString)) * (h->numStrings_ + h->numChunks_);
+    constants = malloc(sizeof (PackageConstants) + capacity);
+    constants->image = image;
+    constants->unpacked = unpacked;
+    unpacked = 0;
+    constants->isMarked = false;
+    constants->isLoading = true;
+    constants->used = 0;
+    constants->capacity = capacity;
+
+    platform_mutex_enter(&vm.heap);
+    constants->next = packageConstants;
+    packageConstants = constants;
+    platform_mutex_leave(&vm.heap);
+
+    ints = malloc(h->numInts_ * sizeof (ObjInt *) + 1);
+    intOffsets = malloc(h->numInts_ * sizeof (uint32_t) + 1);
+    next = intFile;
+    for (int i = 0; i < h->numInts_; i++) {
+        Int const *thisInt = (Int const *)next;
+        intOffsets[i] = (uint32_t)(next - intFile);
+        ints[i] = permanentInt(constants, thisInt);
+        next += sizeof (Int) + sizeof (uint16_t) * thisInt->m_;
+    }
+
     DP(strings__ = (uint32_t)(next - body));
     for (int i = 0; i < h->numStrings_; i++) {
         char const *thisString = (char const *)next;
@@ -75,8 +391,17 @@ struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize) {
     ObjFunction *currentFunction;
     functions = realloc(0, h->numChunks_ * sizeof (ObjFunction *));
 
+    // nothing refers to the functions until their constants are bound, so hold them here.
+    ObjConcreteYargTypeArray *holderType = (ObjConcreteYargTypeArray *)newYargArrayTypeFromType(NIL_VAL, h->numChunks_, 0);
+    tempRootPush(OBJ_VAL(holderType));
+    holder = newPackedUniformArray(holderType);
+    tempRootPop();
+    tempRootPush(OBJ_VAL(holder));
+
     for (int i = 0; i < h->numChunks_; i++) {
         functions[i] = newFunction();
+        functions[i]->package = constants;
+        assignToPackedValue(arrayElement(holder->store, i), OBJ_VAL(functions[i]));
     }
 
     uint8_t const *startOfCode = next;
@@ -96,37 +421,30 @@ struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize) {
     DP(printf("line, offset\n"));
     for (int i = 0; i < h->numLines_; i++) {
         int offset = 0;
+        int line = 0;
         memcpy(&offset, next, 3);
-        if (offset != 0xffffff) {
-            for (int c = 0; c < h->numChunks_; c++) {
-                ObjFunction *cf = functions[c];
-                size_t start = cf->chunk.code - startOfCode;
-                size_t end = start + cf->chunk.count;
-                if (offset >= start && offset < end) {
-                    DP(printf("%d, %d, %d\n", i + 1, offset, offset - (int)start));
-                    if (cf->chunk.numLines == cf->chunk.lineCapacity) {
-                        int capacity = cf->chunk.lineCapacity;
-                        int newCapacity = capacity + 16;
-                        cf->chunk.lineCapacity = newCapacity;
-                        cf->chunk.lines = reallocate(cf->chunk.lines, sizeof (ChunkSource) * capacity, sizeof (ChunkSource) * newCapacity);
-                    }
-                    cf->chunk.lines[cf->chunk.numLines++] = (ChunkSource){ .address = offset - start, .line = i + 1};
-                    break;
-                }
-            }
+        memcpy(&line, next + 3, 3);
+        ObjFunction *cf = functions[chunkAt(functions, h->numChunks_, startOfCode, offset)];
+        size_t start = cf->chunk.code - startOfCode;
+        DP(printf("%d, %d, %d\n", line, offset, offset - (int)start));
+        if (cf->chunk.numLines == cf->chunk.lineCapacity) {
+            int capacity = cf->chunk.lineCapacity;
+            int newCapacity = GROW_CAPACITY(capacity);
+            cf->chunk.lineCapacity = newCapacity;
+            cf->chunk.lines = reallocate(cf->chunk.lines, sizeof (ChunkSource) * capacity, sizeof (ChunkSource) * newCapacity);
         }
-        next += 3;
+        cf->chunk.lines[cf->chunk.numLines++] = (ChunkSource){ .address = offset - start, .line = line};
+        next += 6;
     }
 
     DP(names__ = (uint32_t)(next - body));
     if (h->numLines_ > 0) {
         for (int i = 0; i < h->numChunks_; i++) {
-            functions[i]->fName = copyString((char *)next, (int)strlen((char *)next)); // todo - mark as xip
-            next += 16;
+            functions[i]->fName = permanentString(constants, (char const *)next);
+            next += strlen((char const *)next) + 1;
         }
     }
 
-    DP(end__ = (uint32_t)(next - body));
     assert(h->numChunks_ >= 1);
     for (int i = 0; i < h->numChunks_; i++) {
         currentFunction = functions[i];
@@ -141,21 +459,19 @@ struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize) {
 #endif
             switch (type) {
             case PACK_CONST_TYPE_S: {
-                char *thisString = (char *)&stringFile[index];
-                ObjString *obj = copyString(thisString, (int)strlen(thisString)); // mark as xip
+                char const *thisString = (char const *)&stringFile[index];
+                ObjString *obj = permanentString(constants, thisString);
                 Value value = OBJ_VAL(obj);
                 appendToDynamicValueArray(&currentFunction->chunk.constants, value);
                 DP(printf(":\"%s\"", thisString));
                 break;
             }
             case PACK_CONST_TYPE_I: {
-                Int const *thisInt = (Int const *)&intFile[index];
-                ObjInt *obj = allocateIntObject(thisInt->d_);
-                memcpy(&obj->bigInt, thisInt, sizeof (Int) + obj->bigInt.m_ * sizeof (uint16_t)); // should be able to shallow copy
+                ObjInt *obj = findPermanentInt(ints, intOffsets, h->numInts_, index);
                 Value value = OBJ_VAL(obj);
                 appendToDynamicValueArray(&currentFunction->chunk.constants, value);
                 DP(printf(":");
-                int_print(thisInt));
+                int_print(&obj->bigInt));
                 break;
             }
             case PACK_CONST_TYPE_D: {
@@ -193,7 +509,44 @@ struct ObjFunction *loadPackageFromBuffer(uint8_t* buffer, size_t bufferSize) {
         }
     }
 
+    // after the constants, which the templates are checked against.
+    DP(aot__ = (uint32_t)(next - body));
+    uint8_t const *aot = body + ((next - body + 3) & ~3);
+    uint32_t aotMagic = 0;
+    if (aot + 4 <= body + h->bodyLength_) {
+        memcpy(&aotMagic, aot, 4);
+    }
+    if (aotMagic == PACKAGE_AOT_MAGIC) {
+        next = aot + 4;
+        uint8_t const *aotEnd = body + h->bodyLength_;
+        for (int i = 0; i < h->numChunks_; i++) {
+            uint32_t numOps = 0;
+            if (aotEnd - next < 4) break;
+            memcpy(&numOps, next, 4);
+            next += 4;
+            if (numOps > (uint32_t)(aotEnd - next) / PACKAGE_AOT_OP_SIZE) break;
+#if defined(CYARG_FEATURE_JIT)
+            // run the function on its templates from its first call rather than
+            // waiting for it to become hot; ops that don't match its code are ignored.
+            jitBindPacked(functions[i], (JitPackedOp const *)next, (int)numOps);
+#endif
+            next += numOps * PACKAGE_AOT_OP_SIZE;
+        }
+    }
+
+    DP(end__ = (uint32_t)(next - body));
+
 exit:
+    if (holder != 0) {
+        tempRootPop();
+    }
+    if (constants != 0) {
+        constants->isLoading = false;
+    }
+    free(unpacked);
+    free(chunks);
+    free(ints);
+    free(intOffsets);
     if (functions != 0) {
         currentFunction = functions[0];
         free(functions);
@@ -201,7 +554,7 @@ exit:
         currentFunction = 0;
     }
 
-    DP(printf("chunks__:%u\nints__:%u\nstrings__:%u\ncode__:%u\nlines__:%u\nnames__:%u\nend__:%u\n", chunks__, ints__, strings__, code__, lines__, names__, end__));
+    DP(printf("chunks__:%u\nints__:%u\nstrings__:%u\ncode__:%u\nlines__:%u\nnames__:%u\naot__:%u\nend__:%u\n", chunks__, ints__, strings__, code__, lines__, names__, aot__, end__));
 
     if (r == PACKAGE_OK)
         return currentFunction;
@@ -27,6 +27,9 @@ void initRoutine(ObjRoutine* routine) {
     routine->sliceCount = 1;
     routine->addSlice = addSlice;
 
+    routine->frames = routine->initialFrames;
+    routine->frameCapacity = FRAMES_INITIAL;
+
 #ifdef DEBUG_TRACE_EXECUTION
     routine->traceExecution = true;
 #else
@@ -69,6 +72,52 @@ bool addSlice(ObjRoutine* routine) {
     return (routine->stackSlices != NULL);
 }
 
+static bool growFrames(ObjRoutine* routine, int capacity) {
+    int oldCapacity = routine->frameCapacity;
+    CallFrame* frames;
+    if (routine->frames == routine->initialFrames) {
+        frames = GROW_ARRAY(CallFrame, NULL, 0, capacity);
+        if (frames) {
+            memcpy(frames, routine->initialFrames, sizeof(CallFrame) * oldCapacity);
+        }
+    } else {
+        frames = GROW_ARRAY(CallFrame, routine->frames, oldCapacity, capacity);
+    }
+    if (frames == NULL) {
+        return false;
+    }
+    routine->frames = frames;
+    routine->frameCapacity = capacity;
+    return true;
+}
+
+// Frames start in the routine itself and move to the heap when a call
+// nests deeper; pinned routines cannot allocate so keep to the frames
+// reserved when they were pinned.
+CallFrame* pushFrame(ObjRoutine* routine) {
+    if (routine->frameCount == routine->frameCapacity) {
+        if (routine->addSlice == NULL || routine->frameCapacity >= FRAMES_MAX) {
+            return NULL;
+        }
+
+        int capacity = GROW_CAPACITY(routine->frameCapacity);
+        if (capacity > FRAMES_MAX) {
+            capacity = FRAMES_MAX;
+        }
+        if (!growFrames(routine, capacity)) {
+            return NULL;
+        }
+    }
+
+    return &routine->frames[routine->frameCount++];
+}
+
+void freeRoutineFrames(ObjRoutine* routine) {
+    if (routine->frames != routine->initialFrames) {
+        FREE_ARRAY(CallFrame, routine->frames, routine->frameCapacity);
+    }
+}
+
 ObjRoutine* newRoutine() {
     ObjRoutine* routine = ALLOCATE_OBJ(ObjRoutine, OBJ_ROUTINE);
     tempRootPush(OBJ_VAL(routine));
@@ -78,8 +127,10 @@ ObjRoutine* newRoutine() {
 }
 
 void runAndRenter(ObjRoutine* routine) {
-    run(routine);
-    pop(routine);
+    // A runtime error has already emptied the stack and frames.
+    if (run(routine) == INTERPRET_OK) {
+        pop(routine);
+    }
     pushEntryElements(routine);
     enterEntryFunction(routine);
 }
@@ -90,6 +141,9 @@ bool pinRoutine(ObjRoutine* routine, uintptr_t* address) {
     assert(IS_NIL(routine->entryArg));
     assert(routine->entryFunction->function->arity == 0);
 
+    if (routine->frameCapacity < FRAMES_PINNED && !growFrames(routine, FRAMES_PINNED)) {
+        return false;
+    }
     if (installPinnedRoutine(routine, address)) {
         pushEntryElements(routine);
         enterEntryFunction(routine);
@@ -4,7 +4,9 @@
 #include "value.h"
 #include "object.h"
 
-#define FRAMES_MAX 20
+#define FRAMES_INITIAL 4
+#define FRAMES_MAX 1024
+#define FRAMES_PINNED 20 // reserved up front, as a pinned routine can't allocate
 #define SLICE_MAX 64
 
 typedef struct {
@@ -35,8 +37,10 @@ typedef struct ObjStackSlice{
 typedef struct ObjRoutine {
     Obj obj;
 
-    CallFrame frames[FRAMES_MAX];
+    CallFrame* frames;
     int frameCount;
+    int frameCapacity;
+    CallFrame initialFrames[FRAMES_INITIAL];
 
     StackSlice** stackSlices;
     size_t stackSliceCapacity;
@@ -65,6 +69,7 @@ bool bindEntryFn(ObjRoutine* routine, ObjClosure* closure);
 void bindEntryArgs(ObjRoutine* routine, Value entryArg);
 void pushEntryElements(ObjRoutine* routine);
 void enterEntryFunction(ObjRoutine* routine);
+CallFrame* pushFrame(ObjRoutine* routine);
 ValueCell* frameSlot(ObjRoutine* routine, CallFrame* frame, size_t index);
 Value nativeArgument(ObjRoutine* routine, size_t argCount, size_t argument);
 size_t stackOffsetOf(CallFrame* frame, size_t frameIndex);
@@ -79,6 +84,7 @@ bool startRoutine(ObjRoutine* context, ObjRoutine* target, size_t argCount, Valu
 bool receiveFromRoutine(ObjRoutine* routine, Value* result);
 
 void markRoutine(ObjRoutine* routine);
+void freeRoutineFrames(ObjRoutine* routine);
 
 void push(ObjRoutine* routine, Value value);
 void pushTyped(ObjRoutine* routine, Value value, Value type);
@@ -22,9 +22,8 @@ ObjSyncGroup* newSyncGroup(ObjRoutine* routine, ObjPackedUniformArray* items) {
     push(routine, OBJ_VAL(group));
     platform_critical_section_init(&group->group_lock);
     group->channel_array = items;
-    ObjConcreteYargTypeArray* t = (ObjConcreteYargTypeArray*)newYargArrayTypeFromType(NIL_VAL);
+    ObjConcreteYargTypeArray* t = (ObjConcreteYargTypeArray*)newYargArrayTypeFromType(NIL_VAL, arrayCardinality(items->store), 0);
     push(routine, OBJ_VAL(t));
-    t->cardinality = arrayCardinality(items->store);
     group->result_array = newPackedUniformArray(t);
     pop(routine);
     pop(routine);
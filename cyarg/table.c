@@ -152,6 +152,22 @@ void markTable(ValueTable* table) {
     }
 }
 
+// The capacity that holds count entries within TABLE_MAX_LOAD.
+static int reservedCapacity(int capacity, int count) {
+    int reserved = GROW_CAPACITY(0);
+    while (reserved * TABLE_MAX_LOAD < count) {
+        reserved *= 2;
+    }
+    return reserved > capacity ? reserved : capacity;
+}
+
+void tableReserve(ValueTable* table, int count) {
+    int capacity = reservedCapacity(table->capacity, count);
+    if (capacity > table->capacity) {
+        adjustCapacity(table, capacity);
+    }
+}
+
 void initCellTable(ValueCellTable* table) {
     table->count = 0;
     table->capacity = 0;
@@ -320,3 +336,93 @@ void printCellTable(ValueCellTable* table) {
         }
     }
 }
+
+void initIntegerTable(IntegerTable* table) {
+    table->count = 0;
+    table->capacity = 0;
+    table->entries = NULL;
+}
+
+void freeIntegerTable(IntegerTable* table) {
+    FREE_ARRAY(IntegerEntry, table->entries, table->capacity);
+    initIntegerTable(table);
+}
+
+static uint32_t hashInteger(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static IntegerEntry* findIntegerEntry(IntegerEntry* entries, int capacity, uint64_t key) {
+    uint32_t index = hashInteger(key) & (capacity - 1);
+    for (;;) {
+        IntegerEntry* entry = &entries[index];
+        if (!entry->used || entry->key == key) {
+            return entry;
+        }
+        index = (index + 1) & (capacity - 1);
+    }
+}
+
+static void adjustIntegerCapacity(IntegerTable* table, int capacity) {
+    IntegerEntry* entries = ALLOCATE(IntegerEntry, capacity);
+    for (int i = 0; i < capacity; i++) {
+        entries[i].key = 0;
+        entries[i].used = false;
+        entries[i].value = NIL_VAL;
+    }
+
+    for (int i = 0; i < table->capacity; i++) {
+        IntegerEntry* entry = &table->entries[i];
+        if (!entry->used) continue;
+
+        *findIntegerEntry(entries, capacity, entry->key) = *entry;
+    }
+
+    FREE_ARRAY(IntegerEntry, table->entries, table->capacity);
+    table->entries = entries;
+    table->capacity = capacity;
+}
+
+bool integerTableGet(IntegerTable* table, uint64_t key, Value* value) {
+    if (table->count == 0) return false;
+
+    IntegerEntry* entry = findIntegerEntry(table->entries, table->capacity, key);
+    if (!entry->used) return false;
+
+    *value = entry->value;
+    return true;
+}
+
+bool integerTableSet(IntegerTable* table, uint64_t key, Value value) {
+    if (table->count + 1 > table->capacity * TABLE_MAX_LOAD) {
+        adjustIntegerCapacity(table, GROW_CAPACITY(table->capacity));
+    }
+
+    IntegerEntry* entry = findIntegerEntry(table->entries, table->capacity, key);
+    bool isNewKey = !entry->used;
+    if (isNewKey) table->count++;
+
+    entry->key = key;
+    entry->used = true;
+    entry->value = value;
+    return isNewKey;
+}
+
+void integerTableReserve(IntegerTable* table, int count) {
+    int capacity = reservedCapacity(table->capacity, count);
+    if (capacity > table->capacity) {
+        adjustIntegerCapacity(table, capacity);
+    }
+}
+
+void markIntegerTable(IntegerTable* table) {
+    for (int i = 0; i < table->capacity; i++) {
+        IntegerEntry* entry = &table->entries[i];
+        if (entry->used) {
+            markValue(entry->value);
+        }
+    }
+}
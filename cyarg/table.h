@@ -24,6 +24,7 @@ void tableAddAll(ValueTable* from, ValueTable* to);
 ObjString* tableFindString(ValueTable* table, const char* chars, int length, uint32_t hash);
 void tableRemoveWhite(ValueTable* table);
 void markTable(ValueTable* table);
+void tableReserve(ValueTable* table, int count);
 
 typedef struct {
     ObjString* key;
@@ -48,4 +49,24 @@ void tableCellRemoveWhite(ValueCellTable* table);
 void markCellTable(ValueCellTable* table);
 void printCellTable(ValueCellTable* table);
 
+// Keyed by the bits of a fixed width integer, so nothing is boxed or interned.
+typedef struct {
+    uint64_t key;
+    bool used;
+    Value value;
+} IntegerEntry;
+
+typedef struct {
+    int count;
+    int capacity;
+    IntegerEntry* entries;
+} IntegerTable;
+
+void initIntegerTable(IntegerTable* table);
+void freeIntegerTable(IntegerTable* table);
+bool integerTableGet(IntegerTable* table, uint64_t key, Value* value);
+bool integerTableSet(IntegerTable* table, uint64_t key, Value value);
+void integerTableReserve(IntegerTable* table, int count);
+void markIntegerTable(IntegerTable* table);
+
 #endif
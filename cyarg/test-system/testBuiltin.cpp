@@ -149,11 +149,11 @@ bool syncBuiltin(ObjRoutine *routineContext, int argCount, Value *result)
 {
     vector<string> &log = TestIntrinsics::sync();
         
-    Obj emptyString;
-    ObjConcreteYargType *array{newYargArrayTypeFromType(OBJ_VAL(&emptyString))};
+    ObjConcreteYargType *array{newYargArrayTypeFromType(NIL_VAL, log.size(), 0)};
     ObjConcreteYargTypeArray *arrayAsArray{reinterpret_cast<ObjConcreteYargTypeArray *>(array)};
-    arrayAsArray->cardinality = log.size();
+    tempRootPush(OBJ_VAL(array));
     ObjPackedUniformArray* result_array{newPackedUniformArray(arrayAsArray)};
+    tempRootPush(OBJ_VAL(result_array));
 
     size_t index{0};
     for (auto const &i : log)
@@ -166,6 +166,8 @@ bool syncBuiltin(ObjRoutine *routineContext, int argCount, Value *result)
     }
 
     *result = OBJ_VAL(result_array);
+    tempRootPop();
+    tempRootPop();
     log.clear();
     
     return true;
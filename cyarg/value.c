@@ -22,20 +22,31 @@ PackedValue allocPackedValue(Value type) {
     return value;
 }
 
+// Only the fields in the type's reference bitmap are visited; the field types
+// themselves are reached through the struct type.
 static void markPackedStruct(ObjConcreteYargTypeStruct* type, PackedValueStore* fields) {
-    if (fields) {
-        PackedValue s;
-        s.storedType = (ObjConcreteYargType*)type;
-        s.storedValue = fields;
-        for (int i = 0; i < type->field_count; i++) {
-            PackedValue f = structField(s, i);
-            markPackedValue(f);
+    if (fields && type->holds_references) {
+        for (size_t i = 0; i < type->field_count; i++) {
+            if (!(type->reference_fields[i / 32] & (1u << (i % 32)))) continue;
+
+            StructFieldLayout* layout = &type->fields[i];
+            PackedValueStore* field = (PackedValueStore*)((uint8_t*)fields + layout->offset);
+            switch (layout->packing) {
+                case PackedAsValue: markValue(field->asValue); break;
+                case PackedAsObj: markObject(field->as.obj); break;
+                case PackedAsContainer: {
+                    PackedValue f = { .storedType = layout->type, .storedValue = field };
+                    markPackedValue(f);
+                    break;
+                }
+                case PackedAsScalar: break;
+            }
         }
     }
 }
 
 static void markPackedArray(ObjConcreteYargTypeArray* type, PackedValueStore* elements) {
-    if (elements) {
+    if (elements && type->holds_references) {
         PackedValue array = { .storedType = (ObjConcreteYargType*)type, .storedValue = elements };
         for (size_t i = 0; i < type->cardinality; i++) {
             PackedValue el = arrayElement(array, i);
@@ -21,12 +21,17 @@
 #include "builtin.h"
 #include "routine.h"
 #include "channel.h"
+#include "array_kernel.h"
+#include "map.h"
+#include "pack.h"
+#include "fs/fs.h"
 #include "yargtype.h"
+#ifdef CYARG_FEATURE_JIT
+#include "jit.h"
+#endif
 
 VM vm;
 
-static void binaryIntOp(ObjRoutine* routine, char const *c);
-static void binaryIntBoolOp(ObjRoutine* routine, char const *c);
 static void unaryIntOp(ObjRoutine* routine, int op);
 
 void vmPinnedRoutineHandler(size_t handler) {
@@ -138,6 +143,11 @@ void initVMMemory() {
 
     platform_mutex_init(&vm.heap);
     platform_mutex_init(&vm.env);
+#ifdef CYARG_FEATURE_JIT
+    platform_mutex_init(&vm.jit);
+#endif
+
+    initFileSystem();
 }
 
 void initVMRuntime() {
@@ -161,6 +171,7 @@ void initVMRuntime() {
 
     initCellTable(&vm.globals);
     initTable(&vm.strings);
+    initYargTypeTable(&vm.types);
     
     vm.initString = copyString("init", 4);
 
@@ -177,6 +188,30 @@ void initVMRuntime() {
     defineNative("c_readFileIntoBuffer", readFileIntoBufferNative);
     defineNative("c_fileSize", fileSizeNative);
     defineNative("c_fileExists", fileExistsNative);
+    defineNative("c_fileOpen", fileOpenNative);
+    defineNative("c_fileRead", fileReadNative);
+    defineNative("c_fileWrite", fileWriteNative);
+    defineNative("c_fileSeek", fileSeekNative);
+    defineNative("c_fileClose", fileCloseNative);
+
+    defineNative("array_slice", array_sliceNative);
+    defineNative("array_fill", array_fillNative);
+    defineNative("array_copy", array_copyNative);
+    defineNative("array_copy_range", array_copy_rangeNative);
+    defineNative("array_add", array_addNative);
+    defineNative("array_sub", array_subNative);
+    defineNative("array_mul", array_mulNative);
+    defineNative("array_and", array_andNative);
+    defineNative("array_or", array_orNative);
+    defineNative("array_xor", array_xorNative);
+    defineNative("array_sum", array_sumNative);
+    defineNative("array_min", array_minNative);
+    defineNative("array_max", array_maxNative);
+    defineNative("array_equal", array_equalNative);
+    defineNative("array_find", array_findNative);
+
+    defineNative("map_reserve", map_reserveNative);
+    defineNative("map_keys", map_keysNative);
 
 #if defined(CYARG_FEATURE_HOSTED_REPL)
     defineNative("host_argc", host_argcNative);
@@ -188,9 +223,11 @@ void initVMRuntime() {
 void freeVM() {
     freeCellTable(&vm.globals);
     freeTable(&vm.strings);
+    freeYargTypeTable(&vm.types);
     vm.initString = NULL;
     vm.libraryPath = NULL;
     freeObjects();
+    freePackageConstants();
 }
 
 void markVMRoots() {
@@ -221,12 +258,17 @@ bool callfn(ObjRoutine* routine, ObjClosure* closure, int argCount) {
         return false;
     }
 
-    if (routine->frameCount == FRAMES_MAX) {
+#ifdef CYARG_FEATURE_JIT
+    if (jitCode(closure->function) == NULL) {
+        jitCountCall(closure->function);
+    }
+#endif
+
+    CallFrame* frame = pushFrame(routine);
+    if (frame == NULL) {
         runtimeError(routine, "Stack overflow.");
         return false;
     }
-
-    CallFrame* frame = &routine->frames[routine->frameCount++];
     frame->closure = closure;
     frame->ip = closure->function->chunk.code;
     frame->stackEntryIndex = routine->stackTopIndex - (argCount + 1);
@@ -335,6 +377,7 @@ static ObjUpvalue* captureUpvalue(ObjRoutine* routine, ValueCell* local, size_t
         return upvalue;
     }
 
+    disownInt(local->value);
     ObjUpvalue* createdUpvalue = newUpvalue(local, stackOffset);
     createdUpvalue->next = upvalue;
 
@@ -363,6 +406,46 @@ static void defineMethod(ObjRoutine* routine, ObjString* name) {
     pop(routine);
 }
 
+static bool pointerArrayElement(ObjRoutine* routine, Value pointer, size_t index, PackedValue* element) {
+    PackedValue store = pointerTargetStore(pointer);
+    if (index >= arrayCardinality(store)) {
+        runtimeError(routine, "Array index %zu out of bounds (0:%zu)", index, arrayCardinality(store) - 1);
+        return false;
+    }
+    *element = arrayElement(store, index);
+    return true;
+}
+
+static bool pointerStructField(ObjRoutine* routine, Value pointer, ObjString* name, PackedValue* field) {
+    PackedValue store = pointerTargetStore(pointer);
+    size_t index;
+    if (!structFieldIndex(store.storedType, name, &index)) {
+        runtimeError(routine, "field not present in struct.");
+        return false;
+    }
+    *field = structField(store, index);
+    return true;
+}
+
+static bool setPtrTarget(ObjRoutine* routine) {
+    Value rhs = peek(routine, 0);
+    Value lhs = peek(routine, 1);
+    ObjPackedPointer* pLhs = AS_POINTER(lhs);
+    PackedValue trgLhs = { 
+        .storedType = pLhs->type->target_type, 
+        .storedValue = pLhs->destination 
+    };
+    if (assignToPackedValue(trgLhs, rhs)) {
+        pop(routine);
+        pop(routine);
+        push(routine, rhs);
+        return true;
+    } else {
+        runtimeError(routine, "Cannot set pointer target to incompatible type.");
+        return false;
+    }
+}
+
 static bool derefArrayElement(ObjRoutine* routine) {
     if (!is_positive_integer32(peek(routine, 0))) {
         runtimeError(routine, "Expected an array and a positive or unsigned integer.");
@@ -381,16 +464,11 @@ static bool derefArrayElement(ObjRoutine* routine) {
         result = unpackValue(element);
 
     } else {
-        ObjPackedUniformArray* arrayObj = (ObjPackedUniformArray*)destinationObject(peek(routine, 1));
-        if (index >= arrayCardinality(arrayObj->store)) {
-            runtimeError(routine, "Array index %zu out of bounds (0:%zu)", index, arrayCardinality(arrayObj->store) - 1);
+        PackedValue element;
+        if (!pointerArrayElement(routine, peek(routine, 1), index, &element)) {
             return false;
         }
-        tempRootPush(OBJ_VAL(arrayObj));
-
-        PackedValue element = arrayElement(arrayObj->store, index);
         result = OBJ_VAL(newPointerAtHeapCell(element));
-        tempRootPop();
     }
 
     pop(routine);
@@ -400,13 +478,9 @@ static bool derefArrayElement(ObjRoutine* routine) {
 }
 
 static bool derefMapElement(ObjRoutine* routine, ObjMap* map, Value key) {
-    if (!IS_STRING(key)) {
-        runtimeError(routine, "Expected a string key.");
-        return false;
-    }
     Value result;
-    if (!tableGet(&map->entries, AS_STRING(key), &result)) {
-        result = NIL_VAL;
+    if (!mapGet(routine, map, key, &result)) {
+        return false;
     }
     pop(routine);
     pop(routine);
@@ -452,15 +526,6 @@ static bool setArrayElement(ObjRoutine* routine, ObjPackedUniformArray* array, V
     return true;
 }
 
-static bool setMapElement(ObjRoutine* routine, ObjMap* map, Value key, Value rhs) {
-    if (!IS_STRING(key)) {
-        runtimeError(routine, "Expected a string key for map assignment.");
-        return false;
-    }
-    tableSet(&map->entries, AS_STRING(key), rhs);
-    return true;
-}
-
 static bool setElement(ObjRoutine* routine) {
 
     Value collection = peek(routine, 2);
@@ -470,7 +535,7 @@ static bool setElement(ObjRoutine* routine) {
     bool result = false;
 
     if (IS_MAP(collection)) {
-        result = setMapElement(routine, AS_MAP(collection), index, rhs);
+        result = mapSet(routine, AS_MAP(collection), index, rhs);
     } else if (IS_UNIFORMARRAY(collection)) {
         result = setArrayElement(routine, AS_UNIFORMARRAY(collection), index, rhs);
     } else {
@@ -498,6 +563,217 @@ static void derefPtr(ObjRoutine* routine) {
     push(routine, result);
 }
 
+// *p[i], without the pointer to the element that p[i] would give.
+static bool derefPtrElement(ObjRoutine* routine) {
+    if (isArrayPointer(peek(routine, 1))) {
+        if (!is_positive_integer32(peek(routine, 0))) {
+            runtimeError(routine, "Expected an array and a positive or unsigned integer.");
+            return false;
+        }
+        PackedValue element;
+        if (!pointerArrayElement(routine, peek(routine, 1), as_positive_integer32(peek(routine, 0)), &element)) {
+            return false;
+        }
+        Value result = unpackValue(element);
+        pop(routine);
+        pop(routine);
+        push(routine, result);
+        return true;
+    }
+
+    if (!derefElement(routine)) {
+        return false;
+    }
+    if (!IS_POINTER(peek(routine, 0))) {
+        runtimeError(routine, "Only pointers can be dereferenced.");
+        return false;
+    }
+    derefPtr(routine);
+    return true;
+}
+
+// *p[i] = rhs, without the pointer to the element that p[i] would give.
+static bool setPtrElement(ObjRoutine* routine) {
+    if (isArrayPointer(peek(routine, 2))) {
+        if (!is_positive_integer32(peek(routine, 1))) {
+            runtimeError(routine, "Expected an array and a positive or unsigned integer.");
+            return false;
+        }
+        PackedValue element;
+        if (!pointerArrayElement(routine, peek(routine, 2), as_positive_integer32(peek(routine, 1)), &element)) {
+            return false;
+        }
+        Value rhs = peek(routine, 0);
+        if (!assignToPackedValue(element, rhs)) {
+            runtimeError(routine, "Cannot set pointer target to incompatible type.");
+            return false;
+        }
+        pop(routine);
+        pop(routine);
+        pop(routine);
+        push(routine, rhs);
+        return true;
+    }
+
+    Value rhs = pop(routine);
+    tempRootPush(rhs);
+    bool ok = derefElement(routine);
+    tempRootPop();
+    push(routine, rhs);
+    if (!ok) {
+        return false;
+    }
+    if (!IS_POINTER(peek(routine, 1))) {
+        runtimeError(routine, "Only pointers can be dereferenced.");
+        return false;
+    }
+    return setPtrTarget(routine);
+}
+
+static bool getProperty(ObjRoutine* routine, ObjString* name) {
+    if (!IS_INSTANCE(peek(routine, 0)) && !IS_STRUCT(peek(routine, 0)) && !isStructPointer(peek(routine, 0)) && !IS_INT(peek(routine, 0))) {
+        // int is a very special case, so we'll document the general case for ease of understanding.
+        runtimeError(routine, "Only instances, structs, pointers to structs have properties.");
+        return false;
+    }
+    if (IS_INSTANCE(peek(routine, 0))) {
+        ObjInstance* instance = AS_INSTANCE(peek(routine, 0));
+
+        Value value;
+        if (tableGet(&instance->fields, name, &value)) {
+            pop(routine); // Instance
+            push(routine, value);
+            return true;
+        }
+
+        if (!bindMethod(routine, instance->klass, name)) {
+            runtimeError(routine, "Error");
+            return false;
+        }
+    } else if (IS_STRUCT(peek(routine, 0))) {
+        ObjPackedStruct* object = AS_STRUCT(peek(routine, 0));
+        size_t index;
+        if (!structFieldIndex(object->store.storedType, name, &index)) {
+            runtimeError(routine, "field not present in struct.");
+            return false;
+        }
+        PackedValue f = structField(object->store, index);
+        Value result = unpackValue(f);
+
+        pop(routine);
+        push(routine, result);
+    } else if (isStructPointer(peek(routine, 0))) {
+        PackedValue f;
+        if (!pointerStructField(routine, peek(routine, 0), name, &f)) {
+            return false;
+        }
+        Value result = OBJ_VAL(newPointerAtHeapCell(f));
+
+        pop(routine);
+        push(routine, result);
+    } else if (IS_INT(peek(routine, 0)))
+    {
+        Int *b = AS_INT(pop(routine));
+        if (strcmp(name->chars, "overflow") == 0)
+        {
+            push(routine, BOOL_VAL(b->overflow_));
+        }
+        else
+        {
+            runtimeError(routine, "Undefined property '%s' on int. Only 'overflow' is available.", name->chars);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool setProperty(ObjRoutine* routine, ObjString* name) {
+    if (!IS_INSTANCE(peek(routine, 1)) && !IS_STRUCT(peek(routine, 1))) {
+        runtimeError(routine, "Only instances and structs have fields.");
+        return false;
+    }
+    if (IS_INSTANCE(peek(routine, 1))) {
+        ObjInstance* instance = AS_INSTANCE(peek(routine, 1));
+        tableSet(&instance->fields, name, peek(routine, 0));
+        Value value = pop(routine);
+        pop(routine);
+        push(routine, value);
+    } else if (IS_STRUCT(peek(routine, 1))) {
+        ObjPackedStruct* object = AS_STRUCT(peek(routine, 1));
+        size_t index;
+        if (!structFieldIndex(object->store.storedType, name, &index)) {
+            runtimeError(routine, "field not present in struct.");
+            return false;
+        }
+        PackedValue trg = structField(object->store, index);
+        if (!assignToPackedValue(trg, peek(routine, 0))) {
+            runtimeError(routine, "cannot assign to field type.");
+            return false;
+        }
+        Value result = pop(routine);                 
+        pop(routine);
+        push(routine, result);
+    }
+    return true;
+}
+
+// *p.f, without the pointer to the field that p.f would give.
+static bool derefPtrProperty(ObjRoutine* routine, ObjString* name) {
+    if (isStructPointer(peek(routine, 0))) {
+        PackedValue f;
+        if (!pointerStructField(routine, peek(routine, 0), name, &f)) {
+            return false;
+        }
+        Value result = unpackValue(f);
+        pop(routine);
+        push(routine, result);
+        return true;
+    }
+
+    if (!getProperty(routine, name)) {
+        return false;
+    }
+    if (!IS_POINTER(peek(routine, 0))) {
+        runtimeError(routine, "Only pointers can be dereferenced.");
+        return false;
+    }
+    derefPtr(routine);
+    return true;
+}
+
+// *p.f = rhs, without the pointer to the field that p.f would give.
+static bool setPtrProperty(ObjRoutine* routine, ObjString* name) {
+    if (isStructPointer(peek(routine, 1))) {
+        PackedValue f;
+        if (!pointerStructField(routine, peek(routine, 1), name, &f)) {
+            return false;
+        }
+        Value rhs = peek(routine, 0);
+        if (!assignToPackedValue(f, rhs)) {
+            runtimeError(routine, "Cannot set pointer target to incompatible type.");
+            return false;
+        }
+        pop(routine);
+        pop(routine);
+        push(routine, rhs);
+        return true;
+    }
+
+    Value rhs = pop(routine);
+    tempRootPush(rhs);
+    bool ok = getProperty(routine, name);
+    tempRootPop();
+    push(routine, rhs);
+    if (!ok) {
+        return false;
+    }
+    if (!IS_POINTER(peek(routine, 1))) {
+        runtimeError(routine, "Only pointers can be dereferenced.");
+        return false;
+    }
+    return setPtrTarget(routine);
+}
+
 static bool isFalsey(Value value) {
     return IS_NIL(value) || (IS_BOOL(value) && !AS_BOOL(value));
 }
@@ -614,8 +890,13 @@ InterpretResult run(ObjRoutine* routine) {
     (frame->ip += 2, \
     (uint16_t)((frame->ip[-2] << 8) | frame->ip[-1]))
 
+    // set by OP_WIDE for the constant operand of the instruction after it.
+    int wideOperand = 0;
+    int constantIndex;
+
 #define READ_CONSTANT() \
-    (frame->closure->function->chunk.constants.values[READ_BYTE()])
+    (constantIndex = wideOperand | READ_BYTE(), wideOperand = 0, \
+    frame->closure->function->chunk.constants.values[constantIndex])
 
 #define READ_STRING() AS_STRING(READ_CONSTANT())
 #define BINARY_OP(routine, op) \
@@ -750,6 +1031,11 @@ InterpretResult run(ObjRoutine* routine) {
             disassembleInstruction(&frame->closure->function->chunk, 
                                 (int)(frame->ip - frame->closure->function->chunk.code));
         }
+#ifdef CYARG_FEATURE_JIT
+        else if (jitCode(frame->closure->function) != NULL) {
+            jitRun(routine, frame);
+        }
+#endif
 
         uint8_t instruction;
         switch (instruction = READ_BYTE()) {
@@ -796,11 +1082,52 @@ InterpretResult run(ObjRoutine* routine) {
                 }
                 break;
             }
+            case OP_SET_LOCAL_FIXED: {
+                // the slot holds a boxed Value as any other; a value of the declared type needs no check
+                uint8_t slot = READ_BYTE();
+                ValueType type = (ValueType)READ_BYTE();
+                ValueCell* rhs = peekCell(routine, 0);
+                ValueCell* lhs = frameSlot(routine, frame, slot);
+                if (rhs->value.type == type) {
+                    lhs->value = rhs->value;
+                    break;
+                }
+                ValueCellTarget lhsTrg = { .cellType = lhs->cellType, .value = &lhs->value };
+
+                if (!assignToValueCellTarget(lhsTrg, rhs->value)) {
+                    runtimeError(routine, "Cannot set local variable to incompatible type.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                break;
+            }
             case OP_GET_LOCAL: {
                 uint8_t slot = READ_BYTE();
                 push(routine, frameSlot(routine, frame, slot)->value);
                 break;
             }
+            case OP_GET_LOCAL_INT: {
+                uint8_t slot = READ_BYTE();
+                Value value = frameSlot(routine, frame, slot)->value;
+                disownInt(value); // no longer the slot's alone
+                push(routine, value);
+                break;
+            }
+            case OP_UPDATE_LOCAL_INT: {
+                uint8_t slot = READ_BYTE();
+                uint8_t op = READ_BYTE();
+                if (!updateLocalInt(routine, frame, slot, op)) {
+                    runtimeError(routine, "Operands must both be integers.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                break;
+            }
+            case OP_INT_TEMPORARY: {
+                Value temporary = peek(routine, 0);
+                if (IS_INT(temporary) && !AS_INTOBJ(temporary)->isLiteral) {
+                    AS_INTOBJ(temporary)->isTemporary = true;
+                }
+                break;
+            }
             case OP_GET_GLOBAL: {
                 platform_mutex_enter(&vm.env);
                 ObjString* name = READ_STRING();
@@ -855,7 +1182,9 @@ InterpretResult run(ObjRoutine* routine) {
             }
             case OP_GET_UPVALUE: {
                 uint8_t slot = READ_BYTE();
-                push(routine, frame->closure->upvalues[slot]->contents->value);
+                Value value = frame->closure->upvalues[slot]->contents->value;
+                disownInt(value);
+                push(routine, value);
                 break;
             }
             case OP_SET_UPVALUE: {
@@ -873,98 +1202,15 @@ InterpretResult run(ObjRoutine* routine) {
                 break;
             }
             case OP_GET_PROPERTY: {
-                if (!IS_INSTANCE(peek(routine, 0)) && !IS_STRUCT(peek(routine, 0)) && !isStructPointer(peek(routine, 0)) && !IS_INT(peek(routine, 0))) {
-                    // int is a very special case, so we'll document the general case for ease of understanding.
-                    runtimeError(routine, "Only instances, structs, pointers to structs have properties.");
+                if (!getProperty(routine, READ_STRING())) {
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                if (IS_INSTANCE(peek(routine, 0))) {
-                    ObjInstance* instance = AS_INSTANCE(peek(routine, 0));
-                    ObjString* name = READ_STRING();
-
-                    Value value;
-                    if (tableGet(&instance->fields, name, &value)) {
-                        pop(routine); // Instance
-                        push(routine, value);
-                        break;
-                    }
-
-                    if (!bindMethod(routine, instance->klass, name)) {
-                        runtimeError(routine, "Error");
-                        return INTERPRET_RUNTIME_ERROR;
-                    }
-                } else if (IS_STRUCT(peek(routine, 0))) {
-                    ObjPackedStruct* object = AS_STRUCT(peek(routine, 0));
-                    ObjString* name = READ_STRING();
-                    size_t index;
-                    if (!structFieldIndex(object->store.storedType, name, &index)) {
-                        runtimeError(routine, "field not present in struct.");
-                        return INTERPRET_RUNTIME_ERROR;
-                    }
-                    PackedValue f = structField(object->store, index);
-                    Value result = unpackValue(f);
-
-                    pop(routine);
-                    push(routine, result);
-                } else if (isStructPointer(peek(routine, 0))) {
-                    ObjPackedStruct* object = (ObjPackedStruct*) destinationObject(peek(routine, 0));
-                    tempRootPush(OBJ_VAL(object));
-                    ObjString* name = READ_STRING();
-                    size_t index;
-                    if (!structFieldIndex(object->store.storedType, name, &index)) {
-                        runtimeError(routine, "field not present in struct.");
-                        return INTERPRET_RUNTIME_ERROR;
-                    }
-                    PackedValue f = structField(object->store, index);
-                    Value result = OBJ_VAL(newPointerAtHeapCell(f));
-                    tempRootPop();
-
-                    pop(routine);
-                    push(routine, result);
-                } else if (IS_INT(peek(routine, 0)))
-                {
-                    Int *b = AS_INT(pop(routine));
-                    ObjString* name = READ_STRING();
-                    if (strcmp(name->chars, "overflow") == 0)
-                    {
-                        push(routine, BOOL_VAL(b->overflow_));
-                    }
-                    else
-                    {
-                        runtimeError(routine, "Undefined property '%s' on int. Only 'overflow' is available.", name->chars);
-                        return INTERPRET_RUNTIME_ERROR;
-                    }
-                }
                 break;
             }
             case OP_SET_PROPERTY: {
-                if (!IS_INSTANCE(peek(routine, 1)) && !IS_STRUCT(peek(routine, 1))) {
-                    runtimeError(routine, "Only instances and structs have fields.");
+                if (!setProperty(routine, READ_STRING())) {
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                if (IS_INSTANCE(peek(routine, 1))) {
-                    ObjInstance* instance = AS_INSTANCE(peek(routine, 1));
-                    tableSet(&instance->fields, READ_STRING(), peek(routine, 0));
-                    Value value = pop(routine);
-                    pop(routine);
-                    push(routine, value);
-                } else if (IS_STRUCT(peek(routine, 1))) {
-                    ObjPackedStruct* object = AS_STRUCT(peek(routine, 1));
-                    ObjString* name = READ_STRING();
-                    size_t index;
-                    if (!structFieldIndex(object->store.storedType, name, &index)) {
-                        runtimeError(routine, "field not present in struct.");
-                        return INTERPRET_RUNTIME_ERROR;
-                    }
-                    PackedValue trg = structField(object->store, index);
-                    if (!assignToPackedValue(trg, peek(routine, 0))) {
-                        runtimeError(routine, "cannot assign to field type.");
-                        return INTERPRET_RUNTIME_ERROR;
-                    }
-                    Value result = pop(routine);                 
-                    pop(routine);
-                    push(routine, result);
-                }
                 break;
             }
             case OP_GET_SUPER: {
@@ -1162,7 +1408,8 @@ InterpretResult run(ObjRoutine* routine) {
                 break;
             }
             case OP_PRINT: {
-                printValue(pop(routine));
+                printValue(peek(routine, 0)); // printing a struct or array can allocate.
+                pop(routine);
                 printf("\n");
                 break;
             }
@@ -1249,6 +1496,28 @@ InterpretResult run(ObjRoutine* routine) {
                 frame = &routine->frames[routine->frameCount - 1];
                 break;
             }
+            case OP_TAIL_CALL: {
+                int argCount = READ_BYTE();
+                Value callee = peek(routine, argCount);
+                if (IS_CLOSURE(callee) && AS_CLOSURE(callee)->function->arity == argCount) {
+                    // reuse the returning frame: slide the callee and its
+                    // arguments down over it and call from there.
+                    closeUpvalues(routine, frame->stackEntryIndex);
+                    size_t from = routine->stackTopIndex - (argCount + 1);
+                    for (int i = 0; i <= argCount; i++) {
+                        *frameSlot(routine, frame, i) = *peekCell(routine, (int)(routine->stackTopIndex - 1 - (from + i)));
+                    }
+                    routine->stackTopIndex = frame->stackEntryIndex + argCount + 1;
+                    routine->frameCount--;
+                }
+                // otherwise an ordinary call, with the OP_RETURN following.
+                InterpretResult result = callValue(routine, peek(routine, argCount), argCount);
+                if (result != INTERPRET_OK) {
+                    return result;
+                }
+                frame = &routine->frames[routine->frameCount - 1];
+                break;
+            }
             case OP_INVOKE: {
                 ObjString* method = READ_STRING();
                 int argCount = READ_BYTE();
@@ -1379,7 +1648,7 @@ InterpretResult run(ObjRoutine* routine) {
                     pop(routine);
                     pop(routine);
                 }
-                push(routine, OBJ_VAL(st));
+                push(routine, OBJ_VAL(internYargStructType(st)));
                 tempRootPop();
                 break;
             }
@@ -1389,27 +1658,19 @@ InterpretResult run(ObjRoutine* routine) {
                 ObjConcreteYargType* typeObject = NULL;
 
                 if (IS_NIL(indexer) || IS_YARGTYPE(indexer)) {
-                    ObjConcreteYargTypeMap* mapType = ALLOCATE_OBJ(ObjConcreteYargTypeMap, OBJ_YARGTYPE_MAP);
-                    tempRootPush(OBJ_VAL(mapType));
-                    mapType->core.yt = TypeMap;
-                    mapType->key_type = IS_NIL(indexer) ? NULL : AS_YARGTYPE(indexer);
-                    mapType->value_type = IS_NIL(peek(routine, 1)) ? NULL : AS_YARGTYPE(peek(routine, 1));
-                    if (!isSupportedMapKeyType(OBJ_VAL(mapType))) {
+                    // a map type is supported exactly when its key type is.
+                    if (!isSupportedMapKeyType(indexer)) {
                         runtimeError(routine, "Unsupported map key type.");
-                        tempRootPop();
                         return INTERPRET_RUNTIME_ERROR;
                     }
-                    typeObject = (ObjConcreteYargType*) mapType;
-                    tempRootPop();
+                    typeObject = newYargMapType(indexer, peek(routine, 1));
                 } else if (is_positive_integer32(indexer)) {
                     uint32_t cardinality = as_positive_integer32(indexer);
                     if (cardinality == 0) {
                         runtimeError(routine, "Array cardinality must be non zero.");
                         return INTERPRET_RUNTIME_ERROR;
                     }
-                    ObjConcreteYargTypeArray* array = (ObjConcreteYargTypeArray*) newYargArrayTypeFromType(peek(routine, 1));
-                    array->cardinality = cardinality;
-                    typeObject = (ObjConcreteYargType*) array;
+                    typeObject = newYargArrayTypeFromType(peek(routine, 1), cardinality, 0);
                 } else {
                     runtimeError(routine, "Collection must be array or map.");
                     return INTERPRET_RUNTIME_ERROR;
@@ -1432,23 +1693,39 @@ InterpretResult run(ObjRoutine* routine) {
                 break;
             }
             case OP_SET_PTR_TARGET: {
-                Value rhs = peek(routine, 0);
-                Value lhs = peek(routine, 1);
-                ObjPackedPointer* pLhs = AS_POINTER(lhs);
-                PackedValue trgLhs = { 
-                    .storedType = pLhs->type->target_type, 
-                    .storedValue = pLhs->destination 
-                };
-                if (assignToPackedValue(trgLhs, rhs)) {
-                    pop(routine);
-                    pop(routine);
-                    push(routine, rhs);
-                } else {
-                    runtimeError(routine, "Cannot set pointer target to incompatible type.");
+                if (!setPtrTarget(routine)) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                break;
+            }
+            case OP_DEREF_PTR_ELEMENT: {
+                if (!derefPtrElement(routine)) {
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 break;
             }
+            case OP_SET_PTR_ELEMENT: {
+                if (!setPtrElement(routine)) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                break;
+            }
+            case OP_DEREF_PTR_PROPERTY: {
+                if (!derefPtrProperty(routine, READ_STRING())) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                break;
+            }
+            case OP_SET_PTR_PROPERTY: {
+                if (!setPtrProperty(routine, READ_STRING())) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                break;
+            }
+            case OP_WIDE: {
+                wideOperand = READ_BYTE() << 8;
+                break;
+            }
             case OP_PLACE: {
                 Value location = peek(routine, 0);
                 Value type = peek(routine, 1);
@@ -1583,52 +1860,114 @@ void unaryIntOp(ObjRoutine* routine, int op) {
     push(routine, OBJ_VAL(r));
 }
 
-void binaryIntOp(ObjRoutine* routine, char const *c)
+// The digits a op b can need, from the operands' digits rather than their capacity.
+static int intResultDigits(Int const* a, Int const* b, char op)
 {
-    Int *a = AS_INT(peek(routine, 1));
-    Int *b = AS_INT(peek(routine, 0));
-
     int s = 0;
-    switch (*c)
+    switch (op)
     {
     case '+': case '-':
-        s = 1 + (a->m_ > b->m_ ? a->m_ : b->m_);
+        s = 1 + (a->d_ > b->d_ ? a->d_ : b->d_);
         break;
     case '*':
-        s = a->m_ + b->m_;
+        s = a->d_ + b->d_;
         break;
     case '/':
-        s = a->m_ ;
+        s = a->d_ > b->d_ ? a->d_ - b->d_ + 1 : 1;
         break;
     case '%':
-        s = a->m_ > b->m_ ? a->m_ : b->m_;
+        s = b->d_ + 1; // yarg's % adds the divisor to a negative remainder
         break;
     default:
         assert(!"IntOp");
     }
-    if (s > 254) s = 254;
-    ObjInt *r = allocateIntObject(s);
-    int_init(&r->bigInt);
+    return s > 254 ? 254 : s;
+}
 
-    switch (*c)
-    {
-    case '+': int_add(a, b, &r->bigInt); break;
-    case '-': int_sub(a, b, &r->bigInt); break;
-    case '*': int_mul(a, b, &r->bigInt); break;
-    case '/': int_div(a, b, &r->bigInt, 0); break; // todo - compiler should optimise for /%
-    case '%': {
-        IntConcrete254 q;
-        int_init_concrete254(&q);
-        int_div(a, b, (Int *) &q, &r->bigInt); // todo int_div should handle q == 0
-        break;
+// a op b, computed in place when a may be overwritten and has room for the result.
+static ObjInt* intResult(ObjInt* a, Int const* b, char op, bool inPlace)
+{
+    int s = intResultDigits(&a->bigInt, b, op);
+    ObjInt *r;
+    if (inPlace && a->bigInt.m_ >= s) {
+        r = a;
+        r->bigInt.overflow_ = false;
+    } else {
+        r = allocateIntObject(s);
+        int_init(&r->bigInt);
     }
+
+    switch (op)
+    {
+    case '+': int_add(&a->bigInt, b, &r->bigInt); break;
+    case '-': int_sub(&a->bigInt, b, &r->bigInt); break;
+    case '*': int_mul(&a->bigInt, b, &r->bigInt); break;
+    case '/': int_div(&a->bigInt, b, &r->bigInt, 0); break; // todo - compiler should optimise for /%
+    case '%': int_div(&a->bigInt, b, 0, &r->bigInt); break;
     default:
         assert(!"IntOp");
     }
+    return r;
+}
+
+// a op b, in place only when OP_INT_TEMPORARY marked a for this arithmetic.
+ObjInt* intArithmetic(ObjInt* a, Int const* b, char op)
+{
+    bool inPlace = a->isTemporary;
+    a->isTemporary = false;
+    return intResult(a, b, op, inPlace);
+}
+
+void binaryIntOp(ObjRoutine* routine, char const *c)
+{
+    ObjInt *r = intArithmetic(AS_INTOBJ(peek(routine, 1)), AS_INT(peek(routine, 0)), *c);
     routine->stackTopIndex -= 2;
     push(routine, OBJ_VAL(r));
 }
 
+static bool isCapturedSlot(ObjRoutine* routine, CallFrame* frame, uint8_t slot)
+{
+    size_t stackOffset = stackOffsetOf(frame, slot);
+    for (ObjUpvalue* upvalue = routine->openUpvalues;
+         upvalue != NULL && upvalue->stackOffset >= stackOffset;
+         upvalue = upvalue->next) {
+        if (upvalue->stackOffset == stackOffset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// slot = slot op pop() for a local declared int. The local owns its ObjInt, and
+// updates it in place, until it is read (OP_GET_LOCAL_INT, OP_GET_UPVALUE) or
+// captured.
+bool updateLocalInt(ObjRoutine* routine, CallFrame* frame, uint8_t slot, uint8_t op)
+{
+    Value lhs = frameSlot(routine, frame, slot)->value;
+    if (!IS_INT(lhs) || !IS_INT(peek(routine, 0))) {
+        return false;
+    }
+
+    char intOp;
+    switch (op) {
+        case OP_ADD: intOp = '+'; break;
+        case OP_SUBTRACT: intOp = '-'; break;
+        case OP_MULTIPLY: intOp = '*'; break;
+        case OP_DIVIDE: intOp = '/'; break;
+        case OP_MODULO: intOp = '%'; break;
+        default: return false;
+    }
+
+    ObjInt* a = AS_INTOBJ(lhs);
+    bool owned = !isCapturedSlot(routine, frame, slot);
+    ObjInt* r = intResult(a, AS_INT(peek(routine, 0)), intOp, owned && a->isOwned);
+    a->isOwned = false;
+    r->isOwned = owned;
+    frameSlot(routine, frame, slot)->value = OBJ_VAL(r);
+    pop(routine);
+    return true;
+}
+
 void binaryIntBoolOp(ObjRoutine* routine, char const *op)
 {
     Int *b = AS_INT(pop(routine));
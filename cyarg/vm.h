@@ -9,6 +9,7 @@
 #include "memory.h"
 #include "routine.h"
 #include "platform_hal.h"
+#include "yargtype.h"
 
 #define MAX_PINNED_ROUTINES 10
 
@@ -26,10 +27,14 @@ typedef struct {
     
     ValueCellTable globals;
     ValueTable strings;
+    YargTypeTable types;
     ObjString* initString;
     ObjString* libraryPath;
 
     platform_mutex heap;
+#ifdef CYARG_FEATURE_JIT
+    platform_mutex jit;
+#endif
 
     Value tempRoots[TEMP_ROOTS_MAX];
     Value* tempRootsTop;
@@ -56,6 +61,10 @@ InterpretResult bootBinary(ObjString *script);
 
 InterpretResult run(ObjRoutine* routine);
 bool callfn(ObjRoutine* routine, ObjClosure* closure, int argCount);
+void binaryIntOp(ObjRoutine* routine, char const *c);
+ObjInt* intArithmetic(ObjInt* a, Int const* b, char op);
+bool updateLocalInt(ObjRoutine* routine, CallFrame* frame, uint8_t slot, uint8_t op);
+void binaryIntBoolOp(ObjRoutine* routine, char const *c);
 void fatalVMError(const char* format, ...);
 
 bool installPinnedRoutine(ObjRoutine* pinnedRoutine, uintptr_t* address);
@@ -5,6 +5,33 @@
 #include "memory.h"
 #include "vm.h"
 
+#define TYPE_TABLE_MAX_LOAD 0.75
+
+// Not on the heap, so never traced or swept; marked from the start.
+#define PRIMITIVE_TYPE(t) [t] = { .obj = { .type = OBJ_YARGTYPE, .isMarked = true, .next = NULL }, .yt = t }
+
+static ObjConcreteYargType primitiveTypes[] = {
+    PRIMITIVE_TYPE(TypeAny),
+    PRIMITIVE_TYPE(TypeBool),
+    PRIMITIVE_TYPE(TypeInt),
+    PRIMITIVE_TYPE(TypeDouble),
+    PRIMITIVE_TYPE(TypeInt8),
+    PRIMITIVE_TYPE(TypeUint8),
+    PRIMITIVE_TYPE(TypeInt16),
+    PRIMITIVE_TYPE(TypeUint16),
+    PRIMITIVE_TYPE(TypeInt32),
+    PRIMITIVE_TYPE(TypeUint32),
+    PRIMITIVE_TYPE(TypeInt64),
+    PRIMITIVE_TYPE(TypeUint64),
+    PRIMITIVE_TYPE(TypeString),
+    PRIMITIVE_TYPE(TypeClass),
+    PRIMITIVE_TYPE(TypeInstance),
+    PRIMITIVE_TYPE(TypeFunction),
+    PRIMITIVE_TYPE(TypeRoutine),
+    PRIMITIVE_TYPE(TypeChannel),
+    PRIMITIVE_TYPE(TypeYargType),
+};
+
 ObjConcreteYargType* newYargTypeFromType(ConcreteYargType yt) {
     switch (yt) {
         case TypeAny:
@@ -25,11 +52,9 @@ ObjConcreteYargType* newYargTypeFromType(ConcreteYargType yt) {
         case TypeRoutine:
         case TypeChannel:
         case TypeYargType:
-        case TypeInt : {
-            ObjConcreteYargType* t = ALLOCATE_OBJ(ObjConcreteYargType, OBJ_YARGTYPE);
-            t->yt = yt;
-            return t;
-        }
+        case TypeInt :
+            return &primitiveTypes[yt];
+        // composite types are only allocated here; the constructors below intern them.
         case TypeArray: {
             ObjConcreteYargTypeArray* t = ALLOCATE_OBJ(ObjConcreteYargTypeArray, OBJ_YARGTYPE_ARRAY);
             t->core.yt = yt;
@@ -54,12 +79,219 @@ ObjConcreteYargType* newYargTypeFromType(ConcreteYargType yt) {
     }
 }
 
-ObjConcreteYargType* newYargArrayTypeFromType(Value elementType) {
-    ObjConcreteYargTypeArray* t = (ObjConcreteYargTypeArray*) newYargTypeFromType(TypeArray);
-    if (IS_YARGTYPE(elementType)) {
-        t->element_type = AS_YARGTYPE(elementType);
+void initYargTypeTable(YargTypeTable* table) {
+    table->count = 0;
+    table->capacity = 0;
+    table->entries = NULL;
+}
+
+void freeYargTypeTable(YargTypeTable* table) {
+    FREE_ARRAY(YargTypeEntry, table->entries, table->capacity);
+    initYargTypeTable(table);
+}
+
+static uint32_t mixHash(uint32_t hash, uintptr_t word) {
+    hash ^= (uint32_t)word ^ (uint32_t)((uint64_t)word >> 32);
+    hash *= 16777619u;
+    return hash;
+}
+
+// Component types are canonical already, so they hash and compare by address.
+static uint32_t hashYargType(ObjConcreteYargType* type) {
+    uint32_t hash = mixHash(2166136261u, type->yt);
+    switch (type->yt) {
+        case TypeArray: {
+            ObjConcreteYargTypeArray* a = (ObjConcreteYargTypeArray*)type;
+            hash = mixHash(hash, (uintptr_t)a->element_type);
+            hash = mixHash(hash, a->cardinality);
+            hash = mixHash(hash, a->stride);
+            break;
+        }
+        case TypePointer: {
+            ObjConcreteYargTypePointer* p = (ObjConcreteYargTypePointer*)type;
+            hash = mixHash(hash, (uintptr_t)p->target_type);
+            break;
+        }
+        case TypeMap: {
+            ObjConcreteYargTypeMap* m = (ObjConcreteYargTypeMap*)type;
+            hash = mixHash(hash, (uintptr_t)m->key_type);
+            hash = mixHash(hash, (uintptr_t)m->value_type);
+            break;
+        }
+        case TypeStruct: {
+            ObjConcreteYargTypeStruct* st = (ObjConcreteYargTypeStruct*)type;
+            hash = mixHash(hash, st->field_count);
+            hash = mixHash(hash, st->storage_size);
+            for (size_t i = 0; i < st->field_count; i++) {
+                hash = mixHash(hash, (uintptr_t)st->fields[i].type);
+                hash = mixHash(hash, st->fields[i].offset);
+            }
+            uint32_t names = 0; // the field name table has no order, so sum it.
+            for (int i = 0; i < st->field_names.capacity; i++) {
+                Entry* entry = &st->field_names.entries[i];
+                if (entry->key != NULL) {
+                    names += mixHash(entry->key->hash, AS_UI32(entry->value));
+                }
+            }
+            hash = mixHash(hash, names);
+            break;
+        }
+        default:
+            break;
+    }
+    return hash;
+}
+
+static bool sameFieldNames(ValueTable* a, ValueTable* b) {
+    if (a->count != b->count) {
+        return false;
     }
-    t->core.yt = TypeArray;
+    for (int i = 0; i < a->capacity; i++) {
+        Entry* entry = &a->entries[i];
+        if (entry->key == NULL) continue;
+        Value index;
+        if (!tableGet(b, entry->key, &index) || !valuesEqual(index, entry->value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sameYargType(ObjConcreteYargType* a, ObjConcreteYargType* b) {
+    if (a->yt != b->yt) {
+        return false;
+    }
+    switch (a->yt) {
+        case TypeArray: {
+            ObjConcreteYargTypeArray* lhs = (ObjConcreteYargTypeArray*)a;
+            ObjConcreteYargTypeArray* rhs = (ObjConcreteYargTypeArray*)b;
+            return lhs->element_type == rhs->element_type
+                && lhs->cardinality == rhs->cardinality
+                && lhs->stride == rhs->stride;
+        }
+        case TypePointer:
+            return ((ObjConcreteYargTypePointer*)a)->target_type == ((ObjConcreteYargTypePointer*)b)->target_type;
+        case TypeMap: {
+            ObjConcreteYargTypeMap* lhs = (ObjConcreteYargTypeMap*)a;
+            ObjConcreteYargTypeMap* rhs = (ObjConcreteYargTypeMap*)b;
+            return lhs->key_type == rhs->key_type && lhs->value_type == rhs->value_type;
+        }
+        case TypeStruct: {
+            ObjConcreteYargTypeStruct* lhs = (ObjConcreteYargTypeStruct*)a;
+            ObjConcreteYargTypeStruct* rhs = (ObjConcreteYargTypeStruct*)b;
+            if (lhs->field_count != rhs->field_count || lhs->storage_size != rhs->storage_size) {
+                return false;
+            }
+            for (size_t i = 0; i < lhs->field_count; i++) {
+                if (lhs->fields[i].type != rhs->fields[i].type
+                    || lhs->fields[i].offset != rhs->fields[i].offset) {
+                    return false;
+                }
+            }
+            return sameFieldNames(&lhs->field_names, &rhs->field_names);
+        }
+        default:
+            return a == b;
+    }
+}
+
+static ObjConcreteYargType* findYargType(YargTypeTable* table, ObjConcreteYargType* key, uint32_t hash) {
+    if (table->count == 0) return NULL;
+
+    uint32_t index = hash & (table->capacity - 1);
+    for (;;) {
+        YargTypeEntry* entry = &table->entries[index];
+        if (entry->type == NULL) {
+            // Stop if we find an empty non-tombstone entry.
+            if (entry->hash == 0) return NULL;
+        } else if (entry->hash == hash && sameYargType(entry->type, key)) {
+            return entry->type;
+        }
+
+        index = (index + 1) & (table->capacity - 1);
+    }
+}
+
+static YargTypeEntry* freeYargTypeEntry(YargTypeEntry* entries, int capacity, uint32_t hash) {
+    uint32_t index = hash & (capacity - 1);
+    while (entries[index].type != NULL) {
+        index = (index + 1) & (capacity - 1);
+    }
+    return &entries[index];
+}
+
+static void adjustYargTypeCapacity(YargTypeTable* table, int capacity) {
+    YargTypeEntry* entries = ALLOCATE(YargTypeEntry, capacity);
+    for (int i = 0; i < capacity; i++) {
+        entries[i].hash = 0;
+        entries[i].type = NULL;
+    }
+
+    table->count = 0;
+    for (int i = 0; i < table->capacity; i++) {
+        YargTypeEntry* entry = &table->entries[i];
+        if (entry->type == NULL) continue;
+
+        *freeYargTypeEntry(entries, capacity, entry->hash) = *entry;
+        table->count++;
+    }
+
+    FREE_ARRAY(YargTypeEntry, table->entries, table->capacity);
+    table->entries = entries;
+    table->capacity = capacity;
+}
+
+static void addYargType(YargTypeTable* table, ObjConcreteYargType* type, uint32_t hash) {
+    tempRootPush(OBJ_VAL(type));
+    if (table->count + 1 > table->capacity * TYPE_TABLE_MAX_LOAD) {
+        // the collector leaves tombstones, so rehash in place unless the live types need the room.
+        int live = 0;
+        for (int i = 0; i < table->capacity; i++) {
+            if (table->entries[i].type != NULL) live++;
+        }
+        int capacity = live + 1 > table->capacity * TYPE_TABLE_MAX_LOAD / 2 ? GROW_CAPACITY(table->capacity) : table->capacity;
+        adjustYargTypeCapacity(table, capacity);
+    }
+    YargTypeEntry* entry = freeYargTypeEntry(table->entries, table->capacity, hash);
+    if (entry->hash == 0) table->count++;
+    entry->hash = hash;
+    entry->type = type;
+    tempRootPop();
+}
+
+void yargTypeTableRemoveWhite(YargTypeTable* table) {
+    for (int i = 0; i < table->capacity; i++) {
+        YargTypeEntry* entry = &table->entries[i];
+        if (entry->type != NULL && !entry->type->obj.isMarked) {
+            // Leave a tombstone, a NULL type with a non-zero hash.
+            entry->type = NULL;
+            entry->hash = 1;
+        }
+    }
+}
+
+ObjConcreteYargType* newYargArrayTypeFromType(Value elementType, size_t cardinality, size_t stride) {
+    ObjConcreteYargTypeArray key = {
+        .core.yt = TypeArray,
+        .cardinality = cardinality,
+        .element_type = IS_YARGTYPE(elementType) ? AS_YARGTYPE(elementType) : NULL,
+        .stride = stride
+    };
+    if (stride == arrayElementSize(&key)) {
+        key.stride = 0; // dense, so one type whichever way it was asked for.
+    }
+    uint32_t hash = hashYargType(&key.core);
+    ObjConcreteYargType* found = findYargType(&vm.types, &key.core, hash);
+    if (found != NULL) {
+        return found;
+    }
+
+    ObjConcreteYargTypeArray* t = (ObjConcreteYargTypeArray*) newYargTypeFromType(TypeArray);
+    t->element_type = key.element_type;
+    t->cardinality = cardinality;
+    t->stride = key.stride;
+    t->holds_references = type_holds_references(key.element_type);
+    addYargType(&vm.types, &t->core, hash);
     return (ObjConcreteYargType*)t;
 }
 
@@ -68,6 +300,9 @@ Value arrayElementType(ObjConcreteYargTypeArray* arrayType) {
 }
 
 size_t arrayElementOffset(ObjConcreteYargTypeArray* arrayType, size_t index) {
+    if (arrayType->stride != 0) {
+        return index * arrayType->stride;
+    }
     return index * arrayElementSize(arrayType);
 }
 
@@ -75,46 +310,95 @@ size_t arrayElementSize(ObjConcreteYargTypeArray* arrayType) {
     return yt_sizeof_type_storage(arrayElementType(arrayType));
 }
 
+size_t arrayStorageSize(ObjConcreteYargTypeArray* arrayType) {
+    if (arrayType->cardinality == 0) {
+        return 0;
+    }
+    return arrayElementOffset(arrayType, arrayType->cardinality - 1) + arrayElementSize(arrayType);
+}
+
 ObjConcreteYargType* newYargStructType(size_t fieldCount) {
     ObjConcreteYargTypeStruct* t = (ObjConcreteYargTypeStruct*) newYargTypeFromType(TypeStruct);
     tempRootPush(OBJ_VAL(t));
 
-    ObjConcreteYargType** fieldTypes = ALLOCATE(ObjConcreteYargType*, fieldCount);
+    StructFieldLayout* fields = ALLOCATE(StructFieldLayout, fieldCount);
     for (size_t i = 0; i < fieldCount; i++) {
-        fieldTypes[i] = NULL;
+        fields[i] = (StructFieldLayout){ .type = NULL, .offset = 0, .size = 0, .packing = PackedAsValue };
     }
+    t->fields = fields;
+    t->field_count = fieldCount;
 
-    size_t* fieldIndexes = ALLOCATE(size_t, fieldCount);
-    for (size_t i = 0; i < fieldCount; i++) {
-        fieldIndexes[i] = 0;
+    uint32_t* references = ALLOCATE(uint32_t, REFERENCE_BITMAP_WORDS(fieldCount));
+    for (size_t i = 0; i < REFERENCE_BITMAP_WORDS(fieldCount); i++) {
+        references[i] = 0;
     }
-
-    t->field_indexes = fieldIndexes;
-    t->field_types = fieldTypes;
-    t->field_count = fieldCount;
+    t->reference_fields = references;
 
     tempRootPop();
     return (ObjConcreteYargType*)t;
 }
 
+ObjConcreteYargType* internYargStructType(ObjConcreteYargTypeStruct* st) {
+    uint32_t hash = hashYargType(&st->core);
+    ObjConcreteYargType* found = findYargType(&vm.types, &st->core, hash);
+    if (found != NULL) {
+        return found;
+    }
+    addYargType(&vm.types, &st->core, hash);
+    return &st->core;
+}
+
 ObjConcreteYargType* newYargPointerType(Value targetType) {
-    ObjConcreteYargTypePointer* p = (ObjConcreteYargTypePointer*) newYargTypeFromType(TypePointer);
-    if (IS_YARGTYPE(targetType)) {
-        p->target_type = AS_YARGTYPE(targetType);
+    ObjConcreteYargTypePointer key = {
+        .core.yt = TypePointer,
+        .target_type = IS_YARGTYPE(targetType) ? AS_YARGTYPE(targetType) : NULL
+    };
+    uint32_t hash = hashYargType(&key.core);
+    ObjConcreteYargType* found = findYargType(&vm.types, &key.core, hash);
+    if (found != NULL) {
+        return found;
     }
+
+    ObjConcreteYargTypePointer* p = (ObjConcreteYargTypePointer*) newYargTypeFromType(TypePointer);
+    p->target_type = key.target_type;
+    addYargType(&vm.types, &p->core, hash);
     return (ObjConcreteYargType*)p;
 }
 
+ObjConcreteYargType* newYargMapType(Value keyType, Value valueType) {
+    ObjConcreteYargTypeMap key = {
+        .core.yt = TypeMap,
+        .key_type = IS_YARGTYPE(keyType) ? AS_YARGTYPE(keyType) : NULL,
+        .value_type = IS_YARGTYPE(valueType) ? AS_YARGTYPE(valueType) : NULL
+    };
+    uint32_t hash = hashYargType(&key.core);
+    ObjConcreteYargType* found = findYargType(&vm.types, &key.core, hash);
+    if (found != NULL) {
+        return found;
+    }
+
+    ObjConcreteYargTypeMap* m = (ObjConcreteYargTypeMap*) newYargTypeFromType(TypeMap);
+    m->key_type = key.key_type;
+    m->value_type = key.value_type;
+    addYargType(&vm.types, &m->core, hash);
+    return (ObjConcreteYargType*)m;
+}
+
 size_t addFieldType(ObjConcreteYargTypeStruct* st, size_t index, size_t fieldOffset, Value type, Value offset, Value name) {
-    st->field_types[index] = IS_NIL(type) ? NULL : AS_YARGTYPE(type);
+    StructFieldLayout* field = &st->fields[index];
+    field->type = IS_NIL(type) ? NULL : AS_YARGTYPE(type);
     tableSet(&st->field_names, AS_STRING(name), SIZE_T_UI_VAL(index));
-    if (IS_NIL(offset)) {
-        st->field_indexes[index] = fieldOffset;
-    } else if (is_positive_integer32(offset)) {
+    if (is_positive_integer32(offset)) {
         fieldOffset = as_positive_integer32(offset);
-        st->field_indexes[index] = fieldOffset;
     }
-    st->storage_size = fieldOffset + yt_sizeof_type_storage(type);
+    field->offset = fieldOffset;
+    field->size = yt_sizeof_type_storage(type);
+    field->packing = type_packed_kind(field->type);
+    if (type_holds_references(field->type)) {
+        st->reference_fields[index / 32] |= 1u << (index % 32);
+        st->holds_references = true;
+    }
+    st->storage_size = fieldOffset + field->size;
     return st->storage_size;
 }
 
@@ -179,7 +463,7 @@ Value concrete_typeof(Value a) {
     } else if (IS_POINTER(a)) {
         return OBJ_VAL(AS_POINTER(a)->type);
     } else if (IS_MAP(a)) {
-        return OBJ_VAL(newYargTypeFromType(TypeMap));
+        return OBJ_VAL(AS_MAP(a)->type);
     } else if (IS_INT(a)) {
         return OBJ_VAL(newYargTypeFromType(TypeInt));
     }
@@ -217,6 +501,55 @@ bool type_packs_as_obj(ObjConcreteYargType* type) {
     }
 }
 
+PackedKind type_packed_kind(ObjConcreteYargType* type) {
+    if (type == NULL) {
+        return PackedAsValue;
+    } else if (type_packs_as_container(type)) {
+        return PackedAsContainer;
+    } else if (type_packs_as_obj(type)) {
+        return PackedAsObj;
+    }
+    switch (type->yt) {
+        case TypeInt8:
+        case TypeUint8:
+        case TypeInt16:
+        case TypeUint16:
+        case TypeInt32:
+        case TypeUint32:
+        case TypeInt64:
+        case TypeUint64:
+            return PackedAsScalar;
+        default:
+            return PackedAsValue;
+    }
+}
+
+// Whether storage of this type can hold anything the GC has to reach.
+bool type_holds_references(ObjConcreteYargType* type) {
+    if (type == NULL) {
+        return true;
+    }
+    switch (type->yt) {
+        case TypeBool:
+        case TypeDouble:
+        case TypeInt8:
+        case TypeUint8:
+        case TypeInt16:
+        case TypeUint16:
+        case TypeInt32:
+        case TypeUint32:
+        case TypeInt64:
+        case TypeUint64:
+            return false;
+        case TypeArray:
+            return ((ObjConcreteYargTypeArray*)type)->holds_references;
+        case TypeStruct:
+            return ((ObjConcreteYargTypeStruct*)type)->holds_references;
+        default:
+            return true;
+    }
+}
+
 bool type_packs_as_container(ObjConcreteYargType* type) {
     switch (type->yt) {
         case TypeAny:
@@ -304,7 +637,7 @@ bool is_placeable_type(Value typeVal) {
                 ObjConcreteYargTypeStruct* ct = (ObjConcreteYargTypeStruct*)AS_YARGTYPE(typeVal);
                 bool is_placeable = true;
                 for (size_t i = 0; i < ct->field_count; i++) {
-                    Value fieldType = ct->field_types[i] == NULL ? NIL_VAL : OBJ_VAL(ct->field_types[i]);
+                    Value fieldType = ct->fields[i].type == NULL ? NIL_VAL : OBJ_VAL(ct->fields[i].type);
                     is_placeable &= is_placeable_type(fieldType);
                 }
                 return is_placeable;
@@ -361,7 +694,7 @@ size_t yt_sizeof_type_storage(Value type) {
         }
         case TypeArray: {
             ObjConcreteYargTypeArray* array = (ObjConcreteYargTypeArray*)t;
-            return arrayElementSize(array) * array->cardinality;
+            return arrayStorageSize(array);
         }
         case TypeInt:
         case TypeString:
@@ -423,7 +756,9 @@ static bool isAssignableCardinality(size_t lhsCardinality, size_t rhsCardinality
 static bool isInitializableArray(ObjConcreteYargTypeArray* lhsConcreteType, ObjConcreteYargTypeArray* rhsConcreteType) {
 
     if (isAssignableCardinality(lhsConcreteType->cardinality, rhsConcreteType->cardinality)) {
-        if (lhsConcreteType->element_type == NULL) {
+        if (lhsConcreteType->element_type == rhsConcreteType->element_type) {
+            return true;
+        } else if (lhsConcreteType->element_type == NULL) {
             return true;
         } else if (lhsConcreteType->element_type->yt == TypeAny && rhsConcreteType->element_type == NULL) {
             return true;
@@ -452,6 +787,10 @@ bool isInitialisableType(ObjConcreteYargType* lhsType, Value rhsValue, Value *pr
     Value rhsType = concrete_typeof(rhsValue);
     ObjConcreteYargType* rhsConcreteType = AS_YARGTYPE(rhsType);
 
+    if (lhsType == rhsConcreteType) {
+        return true; // types are canonical
+    }
+
     if (lhsType->yt == TypeArray && rhsConcreteType->yt == TypeArray) {       
         return isInitializableArray((ObjConcreteYargTypeArray*)lhsType, (ObjConcreteYargTypeArray*)rhsConcreteType); 
     } else {
@@ -527,7 +866,7 @@ bool isInitialisableType(ObjConcreteYargType* lhsType, Value rhsValue, Value *pr
     }
 }
 
-// this is a temporary measure, until we have a more complete hashing setup.
+// strings, and the fixed width integers map.c keys by their bits.
 bool isSupportedMapKeyType(Value type) {
     if (IS_YARGTYPE(type)) {
         switch (AS_YARGTYPE(type)->yt) {
@@ -536,6 +875,14 @@ bool isSupportedMapKeyType(Value type) {
                 return isSupportedMapKeyType(mt->key_type ? OBJ_VAL(mt->key_type) : NIL_VAL);
             }
             case TypeString:
+            case TypeInt8:
+            case TypeUint8:
+            case TypeInt16:
+            case TypeUint16:
+            case TypeInt32:
+            case TypeUint32:
+            case TypeInt64:
+            case TypeUint64:
                 return true;
             default:
                 return false;
@@ -590,7 +937,7 @@ static void printTypeLiteral(FILE* op, ObjConcreteYargType* type) {
             ObjConcreteYargTypeStruct* st = (ObjConcreteYargTypeStruct*) type;
             FPRINTMSG(op, "struct{|%zu:%zu| ", st->field_count, st->storage_size);
             for (size_t i = 0; i < st->field_count; i++) {
-                printTypeLiteral(op, st->field_types[i]);
+                printTypeLiteral(op, st->fields[i].type);
                 FPRINTMSG(op, "; ");
             }
             FPRINTMSG(op, "}");
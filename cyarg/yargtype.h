@@ -39,13 +39,33 @@ typedef struct ObjConcreteYargTypeArray {
     ObjConcreteYargType core;
     size_t cardinality;
     ObjConcreteYargType* element_type;
+    size_t stride; // bytes from one element to the next when not packed densely, otherwise 0.
+    bool holds_references; // false when the GC need not look at the elements at all.
 } ObjConcreteYargTypeArray;
 
+// How a value sits in packed storage, and so how the GC has to trace it.
+typedef enum {
+    PackedAsValue,      // a whole Value
+    PackedAsScalar,     // a fixed width integer, nothing to trace
+    PackedAsObj,        // an Obj*
+    PackedAsContainer   // a struct, array or pointer, traced through its type
+} PackedKind;
+
+typedef struct {
+    ObjConcreteYargType* type;
+    size_t offset;
+    size_t size;
+    PackedKind packing;
+} StructFieldLayout;
+
+#define REFERENCE_BITMAP_WORDS(fieldCount) (((fieldCount) + 31) / 32)
+
 typedef struct ObjConcreteYargTypeStruct {
     ObjConcreteYargType core;
     ValueTable field_names;
-    size_t* field_indexes;
-    ObjConcreteYargType** field_types;
+    StructFieldLayout* fields;
+    uint32_t* reference_fields; // bit i set when field i can hold a reference the GC must trace.
+    bool holds_references;
     size_t field_count;
     size_t storage_size;
 } ObjConcreteYargTypeStruct;
@@ -61,14 +81,35 @@ typedef struct ObjConcreteYargTypeMap {
     ObjConcreteYargType* value_type;
 } ObjConcreteYargTypeMap;
 
+// Types are canonical: primitive types are static singletons and composite
+// types are hash-consed, so two types are the same type exactly when they are
+// the same object. The table holds composite types weakly, like vm.strings.
+typedef struct {
+    uint32_t hash;
+    ObjConcreteYargType* type;
+} YargTypeEntry;
+
+typedef struct {
+    int count;
+    int capacity;
+    YargTypeEntry* entries;
+} YargTypeTable;
+
+void initYargTypeTable(YargTypeTable* table);
+void freeYargTypeTable(YargTypeTable* table);
+void yargTypeTableRemoveWhite(YargTypeTable* table);
+
 ObjConcreteYargType* newYargTypeFromType(ConcreteYargType yt);
 
-ObjConcreteYargType* newYargArrayTypeFromType(Value elementType);
+ObjConcreteYargType* newYargArrayTypeFromType(Value elementType, size_t cardinality, size_t stride);
 ObjConcreteYargType* newYargStructType(size_t fieldCount);
+ObjConcreteYargType* internYargStructType(ObjConcreteYargTypeStruct* st);
 ObjConcreteYargType* newYargPointerType(Value targetType);
+ObjConcreteYargType* newYargMapType(Value keyType, Value valueType);
 
 size_t arrayElementOffset(ObjConcreteYargTypeArray* arrayType, size_t index);
 size_t arrayElementSize(ObjConcreteYargTypeArray* arrayType);
+size_t arrayStorageSize(ObjConcreteYargTypeArray* arrayType);
 Value arrayElementType(ObjConcreteYargTypeArray* arrayType);
 
 size_t addFieldType(ObjConcreteYargTypeStruct* st, size_t index, size_t fieldOffset, Value type, Value offset, Value name);
@@ -77,6 +118,8 @@ bool isUint32Pointer(Value val);
 
 Value concrete_typeof(Value a);
 bool type_packs_as_obj(ObjConcreteYargType* type);
+PackedKind type_packed_kind(ObjConcreteYargType* type);
+bool type_holds_references(ObjConcreteYargType* type);
 bool type_packs_as_container(ObjConcreteYargType* type);
 bool is_nil_assignable_type(Value type);
 bool is_placeable_type(Value type);
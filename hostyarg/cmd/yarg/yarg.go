@@ -7,6 +7,7 @@ import (
 	"io/fs"
 	"log"
 	"os"
+	"runtime"
 
 	"github.com/yarg-lang/yarg-lang/hostyarg"
 	"github.com/yarg-lang/yarg-lang/hostyarg/internal/deviceimage"
@@ -167,13 +168,14 @@ func dispatchSubCommand(args []string) {
 		compileSource := flags.String("source", "", "source to compile")
 		compileInterpreter := flags.String("interpreter", "", "default interpreter")
 		compileOutput := flags.String("output", "", "optional output file for compiled binary script")
+		compileCompress := flags.Bool("compress", false, "compress the binary script, unpacked when loaded")
 		flags.Parse(args[1:])
 
 		if *compileSource == "" {
 			exitWithUsageError("expect source to compile")
 		}
 
-		runner := &hostrunner.Compiler{Interpreter: *compileInterpreter}
+		runner := &hostrunner.Compiler{Interpreter: *compileInterpreter, Compress: *compileCompress}
 
 		err := runner.CmdCompile(*compileSource, *compileOutput)
 		if err != nil {
@@ -223,6 +225,8 @@ func dispatchSubCommand(args []string) {
 
 		testHostSource := flags.String("tests", "", "host source of test to run")
 		testDeviceSource := flags.String("device-source", "", "device source of test to run")
+		testJobs := flags.Int("j", runtime.NumCPU(), "number of host tests to run at once")
+		testServe := flags.Bool("serve", false, "fork host tests from one cyarg --serve")
 
 		flags.Parse(args[1:])
 
@@ -240,6 +244,8 @@ func dispatchSubCommand(args []string) {
 			if *testDeviceSource != "" {
 				exitWithUsageError("device source specified but runner is host based")
 			}
+			r.Jobs = *testJobs
+			r.Serve = *testServe
 			err, failedtestcount = r.CmdExpectTest(*testHostSource)
 		} else {
 			err = fmt.Errorf("unknown runner type")
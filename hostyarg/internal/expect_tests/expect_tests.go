@@ -3,6 +3,7 @@ package expect_tests
 import (
 	"bufio"
 	"fmt"
+	"io"
 	"log"
 	"os"
 	"reflect"
@@ -50,7 +51,7 @@ func CreateExpectationTest(testfile, fsname string) (test *testSuite, total int)
 	return test, test.expectations
 }
 
-func CmdReportTestResults(test *testSuite, output, errors []string, code int) (pass int) {
+func CmdReportTestResults(w io.Writer, test *testSuite, output, errors []string, code int) (pass int) {
 
 	if test.validateCode(code) {
 
@@ -67,16 +68,16 @@ func CmdReportTestResults(test *testSuite, output, errors []string, code int) (p
 	test.accountOutputExpectations(output, &pass)
 
 	if pass != test.expectations {
-		fmt.Printf("%v tests %v, passed %v", test.fsname, test.expectations, pass)
+		fmt.Fprintf(w, "%v tests %v, passed %v", test.fsname, test.expectations, pass)
 		if !test.validateCode(code) {
-			fmt.Printf(", exitcode %v (expected: %v)", code, test.expectedExitCode)
+			fmt.Fprintf(w, ", exitcode %v (expected: %v)", code, test.expectedExitCode)
 		}
-		fmt.Println()
+		fmt.Fprintln(w)
 		for l := range output {
-			fmt.Println(output[l])
+			fmt.Fprintln(w, output[l])
 		}
 		for l := range errors {
-			fmt.Println(errors[l])
+			fmt.Fprintln(w, errors[l])
 		}
 	}
 
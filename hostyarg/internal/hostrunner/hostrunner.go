@@ -1,11 +1,16 @@
 package hostrunner
 
 import (
+	"bytes"
 	"fmt"
+	"io"
 	"io/fs"
+	"net"
 	"os"
 	"os/exec"
 	"path/filepath"
+	"sync"
+	"time"
 
 	"github.com/yarg-lang/yarg-lang/hostyarg/internal/deviceutil"
 	"github.com/yarg-lang/yarg-lang/hostyarg/internal/expect_tests"
@@ -14,11 +19,15 @@ import (
 
 type Compiler struct {
 	Interpreter string
+	Compress    bool
 }
 
 type HostRunner struct {
 	Compiler
 	LibPath string
+	Jobs    int
+	Serve   bool
+	server  string
 }
 
 func (h *HostRunner) RunInteractively(source string) error {
@@ -67,7 +76,7 @@ func (h *HostRunner) CmdExpectTest(hostsource string) (err error, failed int) {
 		return fmt.Errorf("Could not stat %v, no library to include in test runs", h.LibPath), 0
 	}
 
-	var grandtotal, grandpass int
+	var testfiles []testFile
 
 	if info.IsDir() {
 		fileSystem := os.DirFS(tests)
@@ -78,37 +87,138 @@ func (h *HostRunner) CmdExpectTest(hostsource string) (err error, failed int) {
 			}
 
 			if !d.IsDir() {
-				testfile := filepath.Join(tests, path)
-				total, pass := h.runTestFile(testfile, path)
-				grandtotal += total
-				grandpass += pass
+				testfiles = append(testfiles, testFile{filepath.Join(tests, path), path})
 			}
 
 			return nil
 		})
 	} else {
-		logname := filepath.Base(tests)
+		testfiles = append(testfiles, testFile{tests, filepath.Base(tests)})
+	}
 
-		grandtotal, grandpass = h.runTestFile(tests, logname)
+	if h.Serve {
+		var stop func()
+		stop, err = h.startServer()
+		if err != nil {
+			return err, 0
+		}
+		defer stop()
 	}
 
+	grandtotal, grandpass := h.runTestFiles(testfiles, os.Stdout)
+
 	fmt.Printf("%s tests: %v, passed: %v\n", tests, grandtotal, grandpass)
 	return err, grandtotal - grandpass
 }
 
-func (h *HostRunner) runTestFile(testfile, fsname string) (total, pass int) {
+type testFile struct {
+	path   string
+	fsname string
+}
+
+type testResult struct {
+	total, pass int
+	report      bytes.Buffer
+	done        chan struct{}
+}
+
+// runTestFiles runs up to Jobs tests at once, reporting each in the order given
+// so the output does not depend on which finishes first.
+func (h *HostRunner) runTestFiles(testfiles []testFile, w io.Writer) (total, pass int) {
+
+	results := make([]testResult, len(testfiles))
+	for i := range results {
+		results[i].done = make(chan struct{})
+	}
+
+	next := make(chan int)
+	go func() {
+		for i := range testfiles {
+			next <- i
+		}
+		close(next)
+	}()
+
+	var wg sync.WaitGroup
+	for range max(h.Jobs, 1) {
+		wg.Go(func() {
+			for i := range next {
+				r := &results[i]
+				r.total, r.pass = h.runTestFile(&r.report, testfiles[i].path, testfiles[i].fsname)
+				close(r.done)
+			}
+		})
+	}
+
+	for i := range results {
+		<-results[i].done
+		w.Write(results[i].report.Bytes())
+		total += results[i].total
+		pass += results[i].pass
+	}
+	wg.Wait()
+
+	return total, pass
+}
+
+func (h *HostRunner) runTestFile(w io.Writer, testfile, fsname string) (total, pass int) {
 
 	test, total := expect_tests.CreateExpectationTest(testfile, fsname)
 
 	output, errors, code, ok := h.RunBatch(testfile)
 	if ok {
-		pass = expect_tests.CmdReportTestResults(test, output, errors, code)
+		pass = expect_tests.CmdReportTestResults(w, test, output, errors, code)
 	}
 
 	return total, pass
 }
 
+// startServer starts a cyarg --serve for RunBatch to fork tests from, rather
+// than starting a process for each.
+func (h *HostRunner) startServer() (stop func(), err error) {
+	dir, err := os.MkdirTemp("", "cyarg-serve")
+	if err != nil {
+		return nil, err
+	}
+	socket := filepath.Join(dir, "cyarg.sock")
+
+	server := exec.Command(h.Interpreter, "--serve", socket)
+	server.Stderr = os.Stderr
+	err = server.Start()
+	if err != nil {
+		os.RemoveAll(dir)
+		return nil, err
+	}
+
+	stop = func() {
+		server.Process.Kill()
+		server.Wait()
+		os.RemoveAll(dir)
+		h.server = ""
+	}
+
+	for waited := 0; ; waited++ {
+		conn, err := net.Dial("unix", socket)
+		if err == nil {
+			conn.Close()
+			break
+		}
+		if waited == 100 {
+			stop()
+			return nil, fmt.Errorf("%v --serve did not start: %v", h.Interpreter, err)
+		}
+		time.Sleep(10 * time.Millisecond)
+	}
+
+	h.server = socket
+	return stop, nil
+}
+
 func (h *HostRunner) RunBatch(source string) (output []string, errors []string, returncode int, ok bool) {
+	if h.server != "" {
+		return runbinary.RunServed(h.server, []string{"--lib", h.LibPath, source})
+	}
+
 	runner := exec.Command(h.Interpreter, "--lib", h.LibPath, source)
 
 	output, errors, returncode, ok = runbinary.RunCommand(runner)
@@ -130,12 +240,14 @@ func (c *Compiler) CmdCompile(source string, output string) error {
 		return fmt.Errorf("Could not stat %v, no interpreter to run", c.Interpreter)
 	}
 
-	return compileFile(c.Interpreter, source, output)
+	return compileFile(c.Interpreter, source, output, c.Compress)
 }
 
-func compileFile(interpreter, source, output string) error {
+func compileFile(interpreter, source, output string, compress bool) error {
 	args := []string{"--compile", source}
-	if output != "" {
+	if output != "" && compress {
+		args = []string{"--compile-compressed", source, output}
+	} else if output != "" {
 		args = append(args, output)
 	}
 	runner := exec.Command(interpreter, args...)
@@ -3,8 +3,14 @@ package runbinary
 import (
 	"bufio"
 	"bytes"
+	"encoding/binary"
 	"fmt"
+	"net"
+	"os"
 	"os/exec"
+	"strings"
+	"sync"
+	"syscall"
 )
 
 func streamToLines(stream bytes.Buffer) (lines []string) {
@@ -40,3 +46,66 @@ func RunCommand(runner *exec.Cmd) (output, errors []string, exitcode int, ok boo
 
 	return output, errors, exitcode, ok
 }
+
+// RunServed runs args in a fork of the cyarg --serve listening on socket, passing
+// it pipes for stdout and stderr in place of starting a process.
+func RunServed(socket string, args []string) (output, errors []string, exitcode int, ok bool) {
+	conn, err := net.DialUnix("unix", nil, &net.UnixAddr{Name: socket, Net: "unix"})
+	if err != nil {
+		fmt.Println("failed executing:", err)
+		return
+	}
+	defer conn.Close()
+
+	stdin, err := os.Open(os.DevNull)
+	if err != nil {
+		fmt.Println("failed executing:", err)
+		return
+	}
+	outRead, outWrite, err := os.Pipe()
+	if err != nil {
+		stdin.Close()
+		fmt.Println("failed executing:", err)
+		return
+	}
+	errRead, errWrite, err := os.Pipe()
+	if err != nil {
+		stdin.Close()
+		outRead.Close()
+		outWrite.Close()
+		fmt.Println("failed executing:", err)
+		return
+	}
+	defer outRead.Close()
+	defer errRead.Close()
+
+	payload := strings.Join(args, "\x00") + "\x00"
+	request := binary.NativeEndian.AppendUint32(nil, uint32(len(payload)))
+	request = append(request, payload...)
+	rights := syscall.UnixRights(int(stdin.Fd()), int(outWrite.Fd()), int(errWrite.Fd()))
+	_, _, err = conn.WriteMsgUnix(request, rights, nil)
+
+	// the run holds the only other ends, so the pipes close when it exits
+	stdin.Close()
+	outWrite.Close()
+	errWrite.Close()
+	if err != nil {
+		fmt.Println("failed executing:", err)
+		return
+	}
+
+	var cstdout, cstderr bytes.Buffer
+	var wg sync.WaitGroup
+	wg.Go(func() { cstdout.ReadFrom(outRead) })
+	wg.Go(func() { cstderr.ReadFrom(errRead) })
+	wg.Wait()
+
+	var code int32
+	err = binary.Read(conn, binary.NativeEndian, &code)
+	if err != nil {
+		fmt.Println("failed executing:", err)
+		return
+	}
+
+	return streamToLines(cstdout), streamToLines(cstderr), int(code), true
+}
@@ -21,16 +21,65 @@ fi
 
 OUTPUT_DIR=`mktemp -d`
 OUTPUT_FILE="$OUTPUT_DIR/simple.yb"
+COMPRESSED_FILE="$OUTPUT_DIR/simple-compressed.yb"
+STREAM_FILE="$OUTPUT_DIR/stream.bin"
 
 $INTERPRETER --compile test/cyarg/simple.ya "$OUTPUT_FILE" || CYARG_ERROR=$?
 $INTERPRETER --lib yarg/specimen "$OUTPUT_FILE" || CYARG_ERROR=$?
-if [ -d "$OUTPUT_DIR" ] && [ -f "$OUTPUT_FILE" ]; then
-    rm "$OUTPUT_FILE"
+$INTERPRETER --compile-compressed test/cyarg/simple.ya "$COMPRESSED_FILE" || CYARG_ERROR=$?
+$INTERPRETER --lib yarg/specimen "$COMPRESSED_FILE" || CYARG_ERROR=$?
+$INTERPRETER --lib yarg/specimen test/cyarg/file-stream.ya -- "$STREAM_FILE" || CYARG_ERROR=$?
+if [ -d "$OUTPUT_DIR" ] && [ -f "$OUTPUT_FILE" ] && [ -f "$COMPRESSED_FILE" ] && [ -f "$STREAM_FILE" ]; then
+    rm "$OUTPUT_FILE" "$COMPRESSED_FILE" "$STREAM_FILE"
     rmdir "$OUTPUT_DIR"
 else
-    echo "Expected output dir to exist at $OUTPUT_DIR and output file to exist at $OUTPUT_FILE"
+    echo "Expected output dir to exist at $OUTPUT_DIR and output files to exist at $OUTPUT_FILE, $COMPRESSED_FILE and $STREAM_FILE"
     CYARG_ERROR=1
 fi
 
+# an aot package, bound to templates as it loads, runs just as its source; without the jit there's none
+AOT_DIR=`mktemp -d`
+AOT_FILE="$AOT_DIR/aot.yb"
+$INTERPRETER --compile-aot test/cyarg/aot.ya "$AOT_FILE" 2>/dev/null
+ERROR=$?
+if [ $ERROR -eq 0 ]; then
+    SOURCE_RUN=`$INTERPRETER --lib yarg/specimen test/cyarg/aot.ya 2>&1`
+    AOT_RUN=`$INTERPRETER --lib yarg/specimen "$AOT_FILE" 2>&1`
+    if [ "$SOURCE_RUN" != "$AOT_RUN" ]; then
+        echo "Expected the aot package to match its source, got:"
+        echo "$AOT_RUN"
+        CYARG_ERROR=1
+    fi
+elif [ $ERROR -ne 69 ]; then
+    echo "Expected an aot package or no jit, got exit code $ERROR"
+    CYARG_ERROR=1
+fi
+rm -rf "$AOT_DIR"
+
+# constants are addressed in 3 bytes, so a string starting past 16MiB can't be packed
+LARGE_DIR=`mktemp -d`
+{ printf 'var a = "'; head -c 17000000 /dev/zero | tr '\0' a; printf '";\nvar b = "b";\n'; } > "$LARGE_DIR/large.ya"
+LARGE_RUN=`$INTERPRETER --compile "$LARGE_DIR/large.ya" "$LARGE_DIR/large.yb" 2>&1`
+ERROR=$?
+if [ $ERROR -ne 65 ] || [ -e "$LARGE_DIR/large.yb" ] || ! echo "$LARGE_RUN" | grep -q "16MiB"; then
+    echo "Expected a package past 16MiB to be refused, got exit code $ERROR:"
+    echo "$LARGE_RUN"
+    CYARG_ERROR=1
+fi
+rm -rf "$LARGE_DIR"
+
+# a compile() cache hit runs and reports errors just as the compile that filled it
+CACHE_DIR=`mktemp -d`
+COLD=`YARG_CACHE="$CACHE_DIR" $INTERPRETER --lib yarg/specimen test/cyarg/compile-cached.ya 2>&1`
+WARM=`YARG_CACHE="$CACHE_DIR" $INTERPRETER --lib yarg/specimen test/cyarg/compile-cached.ya 2>&1`
+if [ -z "`ls "$CACHE_DIR"`" ] || [ "$COLD" != "$WARM" ]; then
+    echo "Expected a cached compile to match the cold one, got:"
+    echo "$COLD"
+    echo "then:"
+    echo "$WARM"
+    CYARG_ERROR=1
+fi
+rm -rf "$CACHE_DIR"
+
 $INTERPRETER --disassemble test/cyarg/simple.ya || CYARG_ERROR=$?
 exit $CYARG_ERROR
\ No newline at end of file
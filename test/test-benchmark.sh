@@ -5,9 +5,24 @@ BENCHMARKS="fib equality string_equality instantiation invocation \
 
 BENCH_ERROR=0
 
+# CYARG_JIT names a cyarg built with -DCYARG_FEATURE_JIT=TRUE; when set, each
+# benchmark is also run on it and the wall clock times of both are reported.
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
 for bench in $BENCHMARKS
 do
+    start=$(now_ms)
     ./bin/yarg run --interpreter bin/cyarg --lib yarg/specimen test/benchmark/$bench.ya || BENCH_ERROR=1
+    interpreted=$(( $(now_ms) - start ))
+
+    if [ -n "$CYARG_JIT" ]; then
+        start=$(now_ms)
+        ./bin/yarg run --interpreter "$CYARG_JIT" --lib yarg/specimen test/benchmark/$bench.ya > /dev/null || BENCH_ERROR=1
+        jit=$(( $(now_ms) - start ))
+        echo "$bench: interpreter ${interpreted}ms, jit ${jit}ms"
+    fi
 done
 
-exit $BENCH_ERROR
\ No newline at end of file
+exit $BENCH_ERROR
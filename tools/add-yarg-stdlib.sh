@@ -1,6 +1,16 @@
 #!/bin/bash
 
 FS_PATH="${1:-build/specimen-fs.uf2}"
+BUILD_DIR=build/stdlib
+
+mkdir -p "$BUILD_DIR"
+
+# the boot path is also carried precompiled, so the device does not compile it on every reset
+for library in yarg repl
+do
+    ./bin/yarg compile --interpreter bin/cyarg --source "yarg/specimen/$library.ya" --output "$BUILD_DIR/$library.yb"
+    ./bin/yarg cp -fs "$FS_PATH" -src "$BUILD_DIR/$library.yb" -dest "$library.yb"
+done
 
 pushd yarg/specimen > /dev/null
 